@@ -3,44 +3,114 @@
 #define MINIPART_BLACKBOX_OPTIMIZER_HH
 
 #include "common.hh"
+#include "partitioning_params.hh"
+#include "stop_condition.hh"
+#include "buffer_pool.hh"
 
 #include <random>
 #include <string>
 
 namespace minipart {
 
+/**
+ * Library entry point: partition a hypergraph whose blocks are set up
+ *
+ * The problem statistics of the parameters are filled from the hypergraph.
+ * Islands are not supported here: see partitionIslands.
+ */
+Solution partition(const Hypergraph &hypergraph, const PartitioningParams &params, const std::vector<Solution> &initialSolutions=std::vector<Solution>());
+
+/**
+ * Partition with params.nIslands worker processes exchanging solutions, as the command line does
+ *
+ * The workers are created with fork(), which only duplicates the calling thread:
+ * call it from a single-threaded program, never while other threads may hold locks.
+ */
+Solution partitionIslands(const Hypergraph &hypergraph, const PartitioningParams &params, const std::vector<Solution> &initialSolutions=std::vector<Solution>());
+
+/**
+ * State kept between many partition() calls, so that small problems do not pay the setup each time
+ *
+ * The buffers are recycled from one call to the next. A context may be shared by several threads,
+ * or each thread may have its own; the number of threads of each call is set per context.
+ * The random generator is seeded from the parameters at each call, so the results do not depend on the previous calls.
+ * Since the calls may run concurrently, islands are rejected: they fork worker processes.
+ */
+class PartitioningContext {
+ public:
+  // Number of threads used by each call; 0 means the global setting
+  explicit PartitioningContext(Index nThreads=0);
+
+  Solution partition(const Hypergraph &hypergraph, const PartitioningParams &params, const std::vector<Solution> &initialSolutions=std::vector<Solution>());
+
+  Index nThreads() const { return nThreads_; }
+
+ private:
+  Index nThreads_;
+  BufferPool pool_;
+};
+
 class BlackboxOptimizer {
  public:
   static Solution run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const std::vector<Solution> &solutions);
+  static Solution run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const std::vector<Solution> &solutions, BufferPool &pool);
 
  private:
-  BlackboxOptimizer(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, std::mt19937 &rgen, std::vector<Solution> &solutions, Index level);
+  BlackboxOptimizer(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, std::mt19937 &rgen, BufferPool &pool, const StopCondition &stop, std::vector<Solution> &solutions, Index level);
+
+  static Solution run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const std::vector<Solution> &solutions, const StopCondition &stop, BufferPool &pool);
+  static Solution run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const std::vector<Solution> &solutions, const StopCondition &stop, IslandMigration *migration, BufferPool &pool);
+  static Solution runIslands(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const std::vector<Solution> &solutions, const StopCondition &stop, BufferPool &pool);
+  static Solution runRecursiveBisection(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const StopCondition &stop, BufferPool &pool);
 
   Solution run();
   Solution bestSolution() const;
+  const std::vector<std::vector<int64_t> > &poolObjectives() const;
   void runInitialPlacement();
+  void runRandomPlacement();
+  void runMultilevelPlacement();
+  void computeClusteringLevels(const Solution &classes, std::vector<Hypergraph> &levels, std::vector<Solution> &coarsenings);
+  void refineLevels(const std::vector<Hypergraph> &levels, const std::vector<Solution> &coarsenings, Solution &solution);
   void runLocalSearch();
   void runVCycle();
+  void prunePool();
+  void resume(const Checkpoint &checkpoint);
+  void writeCheckpoint();
+  void migrate();
+  void runMemetic();
+  Solution recombine(const Solution &parent1, const Solution &parent2);
+  bool isDuplicate(const Solution &solution, const std::vector<int64_t> &obj, const std::vector<std::vector<int64_t> > &objectives) const;
+  std::size_t selectParent(const std::vector<std::vector<int64_t> > &objectives);
 
   void report(const std::string &step) const;
   void report(const std::string &step, Index nSols) const;
   void reportStartCycle() const;
   void reportEndCycle() const;
+  void reportPool(const char *event, Index cycle) const;
   void reportStartSearch() const;
   void reportEndSearch() const;
 
   void checkConsistency() const;
 
   static Solution computeCoarsening(const std::vector<Solution> &solutions);
+  static std::uint64_t hashSolution(const Solution &solution);
 
  private:
   const Hypergraph &hypergraph_;
-  const PartitioningParams &params_;
+  // Copy, as the local search budget is modified when the pool is pruned
+  PartitioningParams params_;
   const Objective &objective_;
   std::mt19937 &rgen_;
+  BufferPool &pool_;
+  const StopCondition &stop_;
   std::vector<Solution> &solutions_;
   Index level_;
   Index cycle_;
+  // Cached objectives of the pool, if up-to-date; cleared when the solutions are modified
+  mutable std::vector<std::vector<int64_t> > objectives_;
+  CheckpointWriter *checkpointWriter_;
+  IslandMigration *migration_;
+  bool resumed_;
 };
 } // End namespace minipart
 
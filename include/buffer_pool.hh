@@ -0,0 +1,37 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_BUFFER_POOL_HH
+#define MINIPART_BUFFER_POOL_HH
+
+#include "common.hh"
+
+#include <mutex>
+
+namespace minipart {
+
+/**
+ * Recycles large buffers between the levels and the cycles of the optimization,
+ * so that their memory is reused instead of being freed and reallocated
+ */
+class BufferPool {
+ public:
+  BufferPool(std::size_t maxBuffers=64) : maxBuffers_(maxBuffers) {}
+
+  // Obtain a buffer of the given size, filled with the value
+  std::vector<Index> get(std::size_t size, Index value=0);
+
+  // Give a buffer back for later reuse
+  void recycle(std::vector<Index> &&buffer);
+
+  std::size_t nBuffers() const;
+
+ private:
+  std::size_t maxBuffers_;
+  std::vector<std::vector<Index> > buffers_;
+  mutable std::mutex mutex_;
+};
+
+} // End namespace minipart
+
+#endif
+
@@ -0,0 +1,59 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_CHECKPOINT_HH
+#define MINIPART_CHECKPOINT_HH
+
+#include "common.hh"
+#include "solution.hh"
+
+#include <string>
+#include <thread>
+#include <exception>
+
+namespace minipart {
+
+/**
+ * State of the search between two cycles, enough to continue it bit-exactly
+ */
+class Checkpoint {
+ public:
+  Index nNodes;
+  Index nParts;
+  // Next cycle or generation to run
+  Index cycle;
+  // Local search budget, modified when the pool is pruned
+  double movesPerElement;
+  // Textual state of the random number generator
+  std::string rgenState;
+  std::vector<Solution> solutions;
+  std::vector<std::vector<int64_t> > objectives;
+
+  // Binary format; the file is replaced atomically
+  static Checkpoint readFile(const std::string &name);
+  void writeFile(const std::string &name) const;
+};
+
+/**
+ * Writes checkpoints in a background thread, so that the search is not stalled
+ *
+ * Only one write is in flight; errors are reported by the next call
+ */
+class CheckpointWriter {
+ public:
+  explicit CheckpointWriter(const std::string &name) : name_(name) {}
+  ~CheckpointWriter();
+
+  void write(Checkpoint &&checkpoint);
+  // Wait for the current write to finish
+  void wait();
+
+ private:
+  std::string name_;
+  std::thread thread_;
+  std::exception_ptr error_;
+};
+
+} // End namespace minipart
+
+#endif
+
@@ -8,11 +8,30 @@
 
 namespace minipart {
 typedef std::int32_t Index;
+// Position in the pin arrays, whose size may exceed the range of Index
+typedef std::int64_t Offset;
+
+/**
+ * Amount of consistency checking performed on the datastructures
+ *   Off:   no check
+ *   Cheap: sizes and bounds, in linear time
+ *   Full:  all checks, including duplicates and incremental state
+ */
+enum class ValidationLevel {
+  Off,
+  Cheap,
+  Full
+};
+
 class Hypergraph;
 class Solution;
 class PartitioningParams;
 class Objective;
 class IncrementalObjective;
+class BufferPool;
+class Checkpoint;
+class CheckpointWriter;
+class IslandMigration;
 } // End namespace minipart
 
 #endif
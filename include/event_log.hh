@@ -0,0 +1,65 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_EVENT_LOG_HH
+#define MINIPART_EVENT_LOG_HH
+
+#include "common.hh"
+
+#include <string>
+#include <chrono>
+
+namespace minipart {
+
+/**
+ * Machine-readable progress events, written as JSON lines
+ *
+ * The destination is a file name, or fd:N for an open file descriptor.
+ * Events are buffered and written by whole lines, so that the log is cheap enough to stay enabled.
+ */
+void openEventLog(const std::string &destination);
+void flushEventLog();
+void closeEventLog();
+bool eventLogEnabled();
+
+/**
+ * A single event; fields are added in order, and the line is written by emit()
+ */
+class Event {
+ public:
+  explicit Event(const char *type);
+
+  Event &add(const char *key, Index value);
+  Event &add(const char *key, std::int64_t value);
+  Event &add(const char *key, double value);
+  Event &add(const char *key, const char *value);
+  Event &add(const char *key, const std::string &value);
+  Event &add(const char *key, const std::vector<std::int64_t> &values);
+  Event &add(const char *key, const std::vector<std::vector<std::int64_t> > &values);
+
+  void emit();
+
+ private:
+  void addKey(const char *key);
+
+ private:
+  std::string line_;
+};
+
+/**
+ * Enter and exit events around a phase of the optimization, with its duration
+ */
+class EventScope {
+ public:
+  EventScope(const char *phase, Index level, const Hypergraph &hypergraph);
+  ~EventScope();
+
+ private:
+  const char *phase_;
+  Index level_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // End namespace minipart
+
+#endif
+
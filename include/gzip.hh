@@ -0,0 +1,53 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_GZIP_HH
+#define MINIPART_GZIP_HH
+
+#include "common.hh"
+
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace minipart {
+
+/**
+ * Gzip compression in independent blocks, compressed and decompressed in parallel
+ *
+ * Each block is a separate gzip member, so that the output is readable by any gzip tool.
+ * Members record their compressed size in an extra field, which lets the reader split
+ * the stream without decompressing it; other gzip files are decompressed sequentially.
+ */
+void setGzipLevel(Index level);
+std::string gzipCompress(const char *begin, const char *end);
+std::string gzipDecompress(const char *begin, const char *end);
+
+/**
+ * Stream buffer compressing its output on the fly
+ *
+ * Data is gathered in blocks; a batch of one block per thread is compressed in parallel,
+ * and the members are written to the underlying stream in order. finish() writes the last blocks.
+ */
+class GzipOutputBuffer : public std::streambuf {
+ public:
+  explicit GzipOutputBuffer(std::ostream &s);
+
+  void finish();
+
+ protected:
+  int_type overflow(int_type c) override;
+
+ private:
+  void compressBatch();
+
+ private:
+  std::ostream &s_;
+  std::vector<char> buffer_;
+  std::vector<std::string> members_;
+  bool written_;
+};
+
+} // End namespace minipart
+
+#endif
@@ -6,31 +6,131 @@
 #include "common.hh"
 #include "solution.hh"
 #include <iosfwd>
+#include <cassert>
+#include <iterator>
+#include <algorithm>
+#include <random>
 
 namespace minipart {
 
-template<typename T>
-class Range {
+inline std::uint32_t readVarint(const std::uint8_t *&ptr) {
+  std::uint32_t ret = 0;
+  int shift = 0;
+  std::uint8_t b;
+  do {
+    b = *ptr++;
+    ret |= (std::uint32_t) (b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return ret;
+}
+
+/**
+ * Pins of a node or hedge in the plain layout
+ */
+class PinRange {
  public:
-  Range(const T *b, const T *e) : begin_(b), end_(e) {}
-  const T *begin() const { return begin_; }
-  const T *end() const { return end_; }
-  const T *cbegin() const { return begin_; }
-  const T *cend() const { return end_; }
+  PinRange(const Index *b, const Index *e) : begin_(b), end_(e) {}
+  const Index *begin() const { return begin_; }
+  const Index *end() const { return end_; }
+  const Index *cbegin() const { return begin_; }
+  const Index *cend() const { return end_; }
   std::size_t size() const { return end_ - begin_; }
 
-  bool operator==(const Range<T> &o) {
-    if (size() != o.size()) return false;
-    for (std::size_t i = 0, sz = size(); i != sz; ++i) {
-      if (begin_[i] != o.begin_[i]) return false;
-    }
-    return true;
+  bool operator==(const PinRange &o) const {
+    return size() == o.size() && std::equal(begin(), end(), o.begin());
+  }
+  bool operator!=(const PinRange &o) const { return !operator==(o); }
+
+ private:
+  const Index *begin_;
+  const Index *end_;
+};
+
+/**
+ * Iterator on the pins of a node or hedge in the compressed layout
+ *
+ * The pins are zigzag-encoded differences between consecutive pins, in varint format, decoded on the fly
+ */
+class CompressedPinIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Index value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const Index *pointer;
+  typedef Index reference;
+
+  CompressedPinIterator(const std::uint8_t *bytes, const std::uint8_t *end)
+    : bytes_(bytes), next_(bytes), end_(end), value_(0) {
+    if (bytes_ != end_) decode();
+  }
+
+  Index operator*() const { return value_; }
+  CompressedPinIterator &operator++() {
+    bytes_ = next_;
+    if (bytes_ != end_) decode();
+    return *this;
+  }
+  CompressedPinIterator operator++(int) { CompressedPinIterator ret = *this; ++*this; return ret; }
+
+  bool operator==(const CompressedPinIterator &o) const { return bytes_ == o.bytes_; }
+  bool operator!=(const CompressedPinIterator &o) const { return !operator==(o); }
+
+ private:
+  void decode() {
+    std::uint32_t v = readVarint(next_);
+    value_ = (Index) ((std::uint32_t) value_ + ((v >> 1) ^ (0u - (v & 1))));
+  }
+
+ private:
+  const std::uint8_t *bytes_;
+  const std::uint8_t *next_;
+  const std::uint8_t *end_;
+  Index value_;
+};
+
+/**
+ * Pins of a node or hedge in the compressed layout, preceded by their number
+ */
+class CompressedPinRange {
+ public:
+  CompressedPinRange(const std::uint8_t *b, const std::uint8_t *e)
+    : begin_(e, e), end_(e, e) {
+    size_ = readVarint(b);
+    begin_ = CompressedPinIterator(b, e);
   }
-  bool operator!=(const Range<T> &o) { return !operator==(o); }
+
+  CompressedPinIterator begin() const { return begin_; }
+  CompressedPinIterator end() const { return end_; }
+  CompressedPinIterator cbegin() const { return begin_; }
+  CompressedPinIterator cend() const { return end_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  CompressedPinIterator begin_;
+  CompressedPinIterator end_;
+  std::size_t size_;
+};
+
+// Tags to select the pin accessors of a layout at compile time
+struct PlainPins {};
+struct CompressedPins {};
+
+/**
+ * Positions of the compressed pin lists, as 32-bit offsets from a 64-bit base for each block of lists
+ */
+class PinOffsets {
+ public:
+  PinOffsets() {}
+  explicit PinOffsets(const std::vector<Offset> &offsets);
+
+  Offset operator[](Index i) const { return bases_[i >> blockBits] + offsets_[i]; }
+  std::int64_t bytes() const;
 
  private:
-  const T *begin_;
-  const T *end_;
+  static const int blockBits = 8;
+  std::vector<Offset> bases_;
+  std::vector<std::uint32_t> offsets_;
 };
 
 class Hypergraph {
@@ -40,69 +140,124 @@ class Hypergraph {
   Index nNodes  () const { return nNodes_; }
   Index nHedges () const { return nHedges_; }
   Index nParts  () const { return nParts_; }
-  Index nPins   () const { return nPins_; }
+  Offset nPins  () const { return nPins_; }
 
   Index nNodeWeights  () const { return nNodeWeights_; }
   Index nHedgeWeights () const { return nHedgeWeights_; }
   Index nPartWeights  () const { return nPartWeights_; }
 
-  Index totalNodeWeight  (Index i=0) const { return totalNodeWeights_[i]; }
-  Index totalHedgeWeight (Index i=0) const { return totalHedgeWeights_[i]; }
-  Index totalPartWeight  (Index i=0) const { return totalPartWeights_[i]; }
+  std::int64_t totalNodeWeight  (Index i=0) const { return totalNodeWeights_[i]; }
+  std::int64_t totalHedgeWeight (Index i=0) const { return totalHedgeWeights_[i]; }
+  std::int64_t totalPartWeight  (Index i=0) const { return totalPartWeights_[i]; }
 
-  Index nodeWeight  (Index node,  Index i=0) const { return nodeData_[nodeBegin_[node] + i]; }
-  Index hedgeWeight (Index hedge, Index i=0) const { return hedgeData_[hedgeBegin_[hedge] + i]; }
+  Index nodeWeight  (Index node,  Index i=0) const { return nodeWeights_[(std::size_t) i * nNodes_ + node]; }
+  Index hedgeWeight (Index hedge, Index i=0) const { return hedgeWeights_[(std::size_t) i * nHedges_ + hedge]; }
   Index partWeight  (Index part,  Index i=0) const { return partData_[part * nPartWeights_ + i]; }
 
-  Range<Index> hedgeNodes(Index hedge) const {
-    const Index *ptr = hedgeData_.data();
-    Index b = hedgeBegin_[hedge] + nHedgeWeights_;
-    Index e = hedgeBegin_[hedge+1];
-    return Range<Index>(ptr + b, ptr + e);
+  // Pins in the plain layout
+  PinRange hedgeNodes(Index hedge) const {
+    assert (!pinsCompressed_);
+    const Index *ptr = hedgePins_.data();
+    return PinRange(ptr + hedgeBegin_[hedge], ptr + hedgeBegin_[hedge+1]);
+  }
+
+  PinRange nodeHedges(Index node) const {
+    assert (!pinsCompressed_);
+    const Index *ptr = nodePins_.data();
+    return PinRange(ptr + nodeBegin_[node], ptr + nodeBegin_[node+1]);
   }
 
-  Range<Index> nodeHedges(Index node) const {
-    const Index *ptr = nodeData_.data();
-    Index b = nodeBegin_[node] + nNodeWeights_;
-    Index e = nodeBegin_[node+1];
-    return Range<Index>(ptr + b, ptr + e);
+  PinRange hedgeNodes(Index hedge, PlainPins) const { return hedgeNodes(hedge); }
+  PinRange nodeHedges(Index node, PlainPins) const { return nodeHedges(node); }
+
+  // Pins in the compressed layout
+  CompressedPinRange hedgeNodes(Index hedge, CompressedPins) const {
+    const std::uint8_t *ptr = hedgeBytes_.data();
+    return CompressedPinRange(ptr + hedgeByteBegin_[hedge], ptr + hedgeByteBegin_[hedge+1]);
+  }
+
+  CompressedPinRange nodeHedges(Index node, CompressedPins) const {
+    const std::uint8_t *ptr = nodeBytes_.data();
+    return CompressedPinRange(ptr + nodeByteBegin_[node], ptr + nodeByteBegin_[node+1]);
+  }
+
+  /**
+   * Call f with the tag of the current layout, PlainPins or CompressedPins
+   *
+   * The traversals in f use hedgeNodes(hedge, layout) and nodeHedges(node, layout):
+   * they are compiled once per layout, so that the plain layout does not pay for the decoding
+   */
+  template<typename F>
+  auto visitPins(F f) const -> decltype(f(PlainPins())) {
+    if (pinsCompressed_) return f(CompressedPins());
+    return f(PlainPins());
   }
 
-  // Metrics
-  Index metricsSumOverflow(const Solution &solution) const;
+  // Compressed storage of the pins, decoded on the fly: less memory, slower traversals
+  void compressPins();
+  bool pinsCompressed() const { return pinsCompressed_; }
+  // Memory used by the pins and their begins, in bytes
+  std::int64_t pinBytes() const;
+
+  // Metrics, summed on 64 bits
+  std::int64_t metricsSumOverflow(const Solution &solution) const;
   Index metricsEmptyPartitions(const Solution &solution) const;
-  Index metricsCut(const Solution &solution) const;
-  Index metricsSoed(const Solution &solution) const;
-  Index metricsConnectivity(const Solution &solution) const;
-  Index metricsMaxDegree(const Solution &solution) const;
-  Index metricsDaisyChainDistance(const Solution &solution) const;
-  Index metricsDaisyChainMaxDegree(const Solution &solution) const;
+  std::int64_t metricsCut(const Solution &solution) const;
+  std::int64_t metricsSoed(const Solution &solution) const;
+  std::int64_t metricsConnectivity(const Solution &solution) const;
+  std::int64_t metricsMaxDegree(const Solution &solution) const;
+  std::int64_t metricsDaisyChainDistance(const Solution &solution) const;
+  std::int64_t metricsDaisyChainMaxDegree(const Solution &solution) const;
   double metricsRatioCut(const Solution &solution) const;
   double metricsRatioSoed(const Solution &solution) const;
   double metricsRatioConnectivity(const Solution &solution) const;
   double metricsRatioMaxDegree(const Solution &solution) const;
 
   double metricsRatioPenalty(const Solution &solution) const;
-  std::vector<Index> metricsPartitionUsage(const Solution &solution) const;
-  std::vector<Index> metricsPartitionDegree(const Solution &solution) const;
-  std::vector<Index> metricsPartitionDaisyChainDegree(const Solution &solution) const;
+  std::vector<std::int64_t> metricsPartitionUsage(const Solution &solution) const;
+  std::vector<std::int64_t> metricsPartitionDegree(const Solution &solution) const;
+  std::vector<std::int64_t> metricsPartitionDaisyChainDegree(const Solution &solution) const;
+
+  /**
+   * Build from the pins of each hedge in CSR format: hedge i has the pins hedgePins[hedgeBegin[i]] to hedgePins[hedgeBegin[i+1]-1]
+   *
+   * Arrays passed with std::move are adopted without copy; the pins are sorted in place and the node side is built from them.
+   * Weights are stored one resource after the other, and all weights are 1 if empty. Blocks are added with setupBlocks().
+   */
+  static Hypergraph fromPins(Index nNodes, std::vector<Offset> hedgeBegin, std::vector<Index> hedgePins,
+                             std::vector<Index> nodeWeights=std::vector<Index>(), std::vector<Index> hedgeWeights=std::vector<Index>());
 
   // IO functions
   static Hypergraph readFile(const std::string &name);
   void writeFile(const std::string &name) const;
   static Hypergraph readHgr(std::istream &);
+  static Hypergraph readHgr(const char *begin, const char *end);
   void writeHgr(std::ostream &) const;
   static Hypergraph readMinipart(std::istream &);
+  static Hypergraph readMinipart(const char *begin, const char *end);
   void writeMinipart(std::ostream &) const;
+  // Binary format with the finalized arrays, loaded without parsing
+  // The arrays are copied out of the mapped file, so loading briefly needs twice their size
+  static Hypergraph readMgb(const char *begin, const char *end);
+  void writeMgb(std::ostream &) const;
 
   // Coarsening
   Hypergraph coarsen(const Solution &coarsening) const;
+  Hypergraph subHypergraph(const Solution &solution, Index part) const;
+  Solution computeHeavyEdgeClustering(std::mt19937 &rgen, Index maxClusterWeight, std::size_t hedgeDegreeCutoff=16) const;
+  // Clustering where nodes are only grouped with nodes of the same class
+  Solution computeHeavyEdgeClustering(std::mt19937 &rgen, Index maxClusterWeight, const Solution &classes, std::size_t hedgeDegreeCutoff=16) const;
+
+  // Reordering for memory locality; the ordering maps each node to its new index, like a coarsening
+  Solution computeLocalityOrdering(std::size_t hedgeDegreeCutoff=64) const;
+  Hypergraph reorder(const Solution &ordering) const;
 
   // Modifications
   void setupBlocks(Index nParts, double imbalanceFactor);
+  void setupBlocks(Index nParts, const std::vector<Index> &capacities);
   void mergeParallelHedges();
 
-  void checkConsistency() const; 
+  void checkConsistency(ValidationLevel level=ValidationLevel::Full) const;
 
  private:
   void finalize();
@@ -111,11 +266,15 @@ class Hypergraph {
   void finalizeNodeWeights();
   void finalizeHedgeWeights();
   void finalizePartWeights();
+  void decompressPins();
+
+  static Index concatenateFragments(const std::vector<std::vector<Offset> > &fragmentBegins, const std::vector<std::vector<Index> > &fragmentData, std::vector<Offset> &begins, std::vector<Index> &data);
+  static void concatenateWeights(const std::vector<std::vector<Index> > &fragmentWeights, Index nWeights, std::vector<Index> &weights);
 
   bool cut(const Solution &solution, Index hedge) const;
   Index degree(const Solution &solution, Index hedge) const;
 
-  static Hypergraph readStream(const std::string &name, std::istream &);
+  static Hypergraph readBuffer(const std::string &name, const char *begin, const char *end);
   void writeStream(const std::string &name, std::ostream &) const;
 
  private:
@@ -123,26 +282,36 @@ class Hypergraph {
   Index nNodes_;
   Index nHedges_;
   Index nParts_;
-  Index nPins_;
+  Offset nPins_;
 
   // Number of resources for each of them
   Index nNodeWeights_;
   Index nHedgeWeights_;
   Index nPartWeights_;
 
-  // Begin/end in the compressed representation
-  std::vector<Index> nodeBegin_;
-  std::vector<Index> hedgeBegin_;
+  // Pins of each node/edge in the compressed representation
+  std::vector<Offset> nodeBegin_;
+  std::vector<Offset> hedgeBegin_;
+  std::vector<Index> nodePins_;
+  std::vector<Index> hedgePins_;
+
+  // Encoded pins; when they are used, the plain begins and pins are empty
+  bool pinsCompressed_;
+  PinOffsets nodeByteBegin_;
+  PinOffsets hedgeByteBegin_;
+  std::vector<std::uint8_t> nodeBytes_;
+  std::vector<std::uint8_t> hedgeBytes_;
 
-  // Data, with the weights then the pins for each node/edge
-  std::vector<Index> nodeData_;
-  std::vector<Index> hedgeData_;
+  // Weights of the nodes/edges, with all nodes/edges contiguous for each resource
+  std::vector<Index> nodeWeights_;
+  std::vector<Index> hedgeWeights_;
+  // Weights of the parts, with all resources contiguous for each part
   std::vector<Index> partData_;
 
   // Summary stats
-  std::vector<Index> totalNodeWeights_;
-  std::vector<Index> totalHedgeWeights_;
-  std::vector<Index> totalPartWeights_;
+  std::vector<std::int64_t> totalNodeWeights_;
+  std::vector<std::int64_t> totalHedgeWeights_;
+  std::vector<std::int64_t> totalPartWeights_;
 };
 
 } // End namespace minipart
@@ -0,0 +1,42 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_HYPERGRAPH_CACHE_HH
+#define MINIPART_HYPERGRAPH_CACHE_HH
+
+#include "common.hh"
+
+#include <string>
+
+namespace minipart {
+
+/**
+ * Directory of preprocessed hypergraphs in the binary format, for repeated runs on the same input
+ *
+ * Entries are keyed by a hash of the input file contents and of the preprocessing options,
+ * so that a modified input never hits a stale entry. Entries that cannot be read,
+ * for example because they were written by another version, are removed.
+ * The least recently used entries are removed when the directory exceeds its size limit.
+ */
+class HypergraphCache {
+ public:
+  HypergraphCache(const std::string &directory, std::int64_t maxBytes);
+
+  std::string key(const std::string &inputFile, const std::string &options) const;
+
+  // Read the entry if it is present and valid
+  bool read(const std::string &key, Hypergraph &hypergraph) const;
+  // Failing to write an entry is not an error: a warning is printed
+  void write(const std::string &key, const Hypergraph &hypergraph) const;
+
+ private:
+  std::string entryPath(const std::string &key) const;
+  void evict() const;
+
+ private:
+  std::string directory_;
+  std::int64_t maxBytes_;
+};
+
+} // End namespace minipart
+
+#endif
@@ -4,6 +4,7 @@
 #define MINIPART_INCREMENTAL_OBJECTIVE_HH
 
 #include "hypergraph.hh"
+#include "buffer_pool.hh"
 
 namespace minipart {
 
@@ -12,7 +13,7 @@ namespace minipart {
  */
 class IncrementalObjective {
  public:
-  IncrementalObjective(const Hypergraph &hypergraph, Solution &solution, Index nObjectives);
+  IncrementalObjective(const Hypergraph &hypergraph, Solution &solution, Index nObjectives, BufferPool *pool=nullptr);
 
   virtual void move(Index node, Index to) =0;
   virtual void checkConsistency() const;
@@ -26,17 +27,27 @@ class IncrementalObjective {
   const Solution& solution() const { return solution_; }
   const std::vector<int64_t>& objectives() const { return objectives_; }
 
-  virtual ~IncrementalObjective() {}
+  virtual ~IncrementalObjective();
+
+ protected:
+  // Number of pins of the hedge in each partition
+  Index *hedgePins(Index hedge) { return hedgeNbPinsPerPartition_.data() + (std::size_t) hedge * nParts(); }
 
  protected:
   const Hypergraph &hypergraph_;
   Solution &solution_;
   std::vector<int64_t> objectives_;
+  BufferPool *pool_;
+
+  // State common to all objectives, with buffers obtained from the pool
+  std::vector<std::int64_t> partitionDemands_;
+  std::vector<Index> hedgeNbPinsPerPartition_;
+  std::vector<Index> hedgeDegrees_;
 };
 
 class IncrementalCut final : public IncrementalObjective {
  public:
-  IncrementalCut(const Hypergraph &hypergraph, Solution &solution);
+  IncrementalCut(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -44,16 +55,13 @@ class IncrementalCut final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  Index currentCut_;
-  Index currentSoed_;
+  std::int64_t currentCut_;
+  std::int64_t currentSoed_;
 };
 
 class IncrementalSoed final : public IncrementalObjective {
  public:
-  IncrementalSoed(const Hypergraph &hypergraph, Solution &solution);
+  IncrementalSoed(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -61,15 +69,12 @@ class IncrementalSoed final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  Index currentSoed_;
+  std::int64_t currentSoed_;
 };
 
 class IncrementalMaxDegree final : public IncrementalObjective {
  public:
-  IncrementalMaxDegree(const Hypergraph &hypergraph, Solution &solution);
+  IncrementalMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -77,16 +82,13 @@ class IncrementalMaxDegree final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  std::vector<Index> partitionDegrees_;
-  Index currentSoed_;
+  std::vector<std::int64_t> partitionDegrees_;
+  std::int64_t currentSoed_;
 };
 
 class IncrementalDaisyChainDistance final : public IncrementalObjective {
  public:
-  IncrementalDaisyChainDistance (const Hypergraph &hypergraph, Solution &solution);
+  IncrementalDaisyChainDistance(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -94,18 +96,15 @@ class IncrementalDaisyChainDistance final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
   std::vector<std::pair<Index, Index> > hedgeMinMax_;
-  Index currentDistance_;
-  Index currentSoed_;
+  std::int64_t currentDistance_;
+  std::int64_t currentSoed_;
 };
 
 
 class IncrementalDaisyChainMaxDegree final : public IncrementalObjective {
  public:
-  IncrementalDaisyChainMaxDegree (const Hypergraph &hypergraph, Solution &solution);
+  IncrementalDaisyChainMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -113,17 +112,14 @@ class IncrementalDaisyChainMaxDegree final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
   std::vector<std::pair<Index, Index> > hedgeMinMax_;
-  std::vector<Index> partitionDegrees_;
-  Index currentDistance_;
+  std::vector<std::int64_t> partitionDegrees_;
+  std::int64_t currentDistance_;
 };
 
 class IncrementalRatioCut final : public IncrementalObjective {
  public:
-  IncrementalRatioCut (const Hypergraph &hypergraph, Solution &solution);
+  IncrementalRatioCut(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -131,16 +127,13 @@ class IncrementalRatioCut final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  Index currentCut_;
-  Index currentSoed_;
+  std::int64_t currentCut_;
+  std::int64_t currentSoed_;
 };
 
 class IncrementalRatioSoed final : public IncrementalObjective {
  public:
-  IncrementalRatioSoed (const Hypergraph &hypergraph, Solution &solution);
+  IncrementalRatioSoed(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -148,16 +141,13 @@ class IncrementalRatioSoed final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  Index currentCut_;
-  Index currentSoed_;
+  std::int64_t currentCut_;
+  std::int64_t currentSoed_;
 };
 
 class IncrementalRatioMaxDegree final : public IncrementalObjective {
  public:
-  IncrementalRatioMaxDegree(const Hypergraph &hypergraph, Solution &solution);
+  IncrementalRatioMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool=nullptr);
   void move(Index node, Index to) override;
   void checkConsistency() const override;
 
@@ -165,11 +155,8 @@ class IncrementalRatioMaxDegree final : public IncrementalObjective {
   void setObjective();
 
  private:
-  std::vector<Index> partitionDemands_;
-  std::vector<std::vector<Index> > hedgeNbPinsPerPartition_;
-  std::vector<Index> hedgeDegrees_;
-  std::vector<Index> partitionDegrees_;
-  Index currentSoed_;
+  std::vector<std::int64_t> partitionDegrees_;
+  std::int64_t currentSoed_;
 };
 
 
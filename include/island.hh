@@ -0,0 +1,94 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_ISLAND_HH
+#define MINIPART_ISLAND_HH
+
+#include "common.hh"
+#include "solution.hh"
+
+#include <functional>
+#include <memory>
+
+namespace minipart {
+
+enum class IslandMessageType {
+  // Best solution of a worker after a cycle; the worker waits for a migrant
+  Elite,
+  // Solution sent back to a worker by the coordinator
+  Migrant,
+  // Last message of a worker, with its best solution
+  Final
+};
+
+/**
+ * Exchange of solutions between a worker and the coordinator
+ *
+ * The transport is pluggable; the local implementation uses Unix domain sockets
+ */
+class IslandTransport {
+ public:
+  virtual ~IslandTransport() {}
+  virtual void send(IslandMessageType type, const Solution &solution) = 0;
+  // Blocking; throws if the other side disconnected
+  virtual IslandMessageType receive(Solution &solution) = 0;
+};
+
+/**
+ * Transport over a connected stream socket
+ */
+class SocketTransport : public IslandTransport {
+ public:
+  explicit SocketTransport(int fd) : fd_(fd) {}
+  ~SocketTransport();
+
+  void send(IslandMessageType type, const Solution &solution) override;
+  IslandMessageType receive(Solution &solution) override;
+
+ private:
+  int fd_;
+};
+
+/**
+ * Worker side of the island model
+ */
+class IslandMigration {
+ public:
+  IslandMigration(IslandTransport &transport, Index interval)
+    : transport_(transport), interval_(interval) {}
+
+  // Whether the worker exchanges solutions after this cycle
+  bool isMigrationCycle(Index cycle) const { return interval_ > 0 && (cycle + 1) % interval_ == 0; }
+
+  // Send the best solution of the pool and obtain a solution from another island
+  Solution exchange(const Solution &elite);
+
+ private:
+  IslandTransport &transport_;
+  Index interval_;
+};
+
+/**
+ * Coordinator of the island model
+ *
+ * Workers run in separate processes; at each round, every island receives the
+ * latest elite of the previous island in a ring. Rounds are synchronous, so that
+ * the result does not depend on the timing of the workers.
+ */
+class IslandCoordinator {
+ public:
+  // Start the worker processes; each one runs the function and sends its result back
+  IslandCoordinator(Index nIslands, const std::function<Solution(Index, IslandMigration&)> &worker, Index migrationInterval);
+  ~IslandCoordinator();
+
+  // Run the exchanges until all workers are done, and return the global best solution
+  Solution run(const Hypergraph &hypergraph, const Objective &objective, int verbosity);
+
+ private:
+  std::vector<std::unique_ptr<IslandTransport> > transports_;
+  std::vector<int> pids_;
+};
+
+} // End namespace minipart
+
+#endif
+
@@ -5,6 +5,7 @@
 #include "hypergraph.hh"
 #include "incremental_objective.hh"
 #include "move.hh"
+#include "stop_condition.hh"
 
 #include <random>
 #include <iosfwd>
@@ -17,7 +18,7 @@ class Move;
 
 class LocalSearchOptimizer {
  public:
-  LocalSearchOptimizer(IncrementalObjective &inc, const PartitioningParams &params, std::mt19937 &rgen);
+  LocalSearchOptimizer(IncrementalObjective &inc, const PartitioningParams &params, std::mt19937 &rgen, const StopCondition &stop);
   void run();
 
  private:
@@ -29,6 +30,7 @@ class LocalSearchOptimizer {
   IncrementalObjective &inc_;
   const PartitioningParams &params_;
   std::mt19937 &rgen_;
+  const StopCondition &stop_;
   std::vector<std::unique_ptr<Move> > moves_;
 };
 
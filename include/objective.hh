@@ -4,6 +4,7 @@
 #define MINIPART_OBJECTIVE_HH
 
 #include "common.hh"
+#include "partitioning_params.hh"
 #include <memory>
 
 namespace minipart {
@@ -13,56 +14,58 @@ namespace minipart {
  */
 class Objective {
  public:
-  virtual std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const =0;
+  virtual std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *pool=nullptr) const =0;
   virtual std::vector<int64_t> eval(const Hypergraph &, Solution &) const =0;
   virtual ~Objective() {}
+
+  static std::unique_ptr<Objective> create(ObjectiveType type);
 };
 
 class CutObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class SoedObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class MaxDegreeObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class DaisyChainDistanceObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class DaisyChainMaxDegreeObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class RatioCutObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class RatioSoedObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
 class RatioMaxDegreeObjective final : public Objective {
  public:
-  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &) const override;
+  std::unique_ptr<IncrementalObjective> incremental(const Hypergraph &, Solution &, BufferPool *) const override;
   std::vector<int64_t> eval(const Hypergraph &, Solution &) const override;
 };
 
@@ -0,0 +1,81 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_PARALLEL_HH
+#define MINIPART_PARALLEL_HH
+
+#include "common.hh"
+
+#include <functional>
+#include <algorithm>
+
+namespace minipart {
+
+/**
+ * Number of threads used by the parallel algorithms; 0 means the hardware concurrency
+ */
+void setNThreads(Index nThreads);
+Index nThreads();
+
+/**
+ * Number of threads for the parallel calls made by the current thread while the object lives; 0 keeps the global setting
+ */
+class ThreadCountScope {
+ public:
+  explicit ThreadCountScope(Index nThreads);
+  ~ThreadCountScope();
+
+ private:
+  Index previous_;
+};
+
+/**
+ * Number of chunks to use to process n elements in parallel
+ */
+Index nChunks(Index n, Index grainSize=4096);
+
+inline Index chunkBegin(Index n, Index nChunks, Index chunk) {
+  return (std::int64_t) n * chunk / nChunks;
+}
+
+/**
+ * Split [0, n) into nChunks contiguous chunks and call f(chunk, begin, end) on each of them in parallel
+ *
+ * Chunks are ordered, so that per-chunk results can be concatenated deterministically
+ */
+void parallelChunks(Index n, Index nChunks, const std::function<void(Index, Index, Index)> &f);
+
+/**
+ * Sort chunks in parallel, then merge them pairwise
+ */
+template<typename It, typename Compare>
+void parallelSort(It begin, It end, Compare comp) {
+  Index n = end - begin;
+  Index nc = nChunks(n);
+  if (nc <= 1) {
+    std::sort(begin, end, comp);
+    return;
+  }
+  parallelChunks(n, nc, [&](Index, Index b, Index e) {
+    std::sort(begin + b, begin + e, comp);
+  });
+  for (Index width = 1; width < nc; width *= 2) {
+    Index nMerges = (nc + 2 * width - 1) / (2 * width);
+    parallelChunks(nMerges, nMerges, [&](Index, Index b, Index e) {
+      for (Index m = b; m < e; ++m) {
+        Index first = 2 * width * m;
+        Index middle = std::min(first + width, nc);
+        Index last = std::min(first + 2 * width, nc);
+        std::inplace_merge(
+          begin + chunkBegin(n, nc, first),
+          begin + chunkBegin(n, nc, middle),
+          begin + chunkBegin(n, nc, last),
+          comp);
+      }
+    });
+  }
+}
+
+} // End namespace minipart
+
+#endif
+
@@ -5,6 +5,7 @@
 #include "common.hh"
 
 #include <iosfwd>
+#include <string>
 
 namespace minipart {
 
@@ -63,28 +64,87 @@ enum class ObjectiveType {
 std::istream & operator>>(std::istream &, ObjectiveType&);
 std::ostream & operator<<(std::ostream &, const ObjectiveType&);
 
+enum class InitialPlacement {
+  /*
+   * Assign each node to a random block
+   */
+  Random,
+
+  /*
+   * Cluster the nodes along heavy hyperedges,
+   * partition the coarsest hypergraph and refine while uncoarsening
+   */
+  Multilevel
+};
+
+std::istream & operator>>(std::istream &, InitialPlacement&);
+std::ostream & operator<<(std::ostream &, const InitialPlacement&);
+
+enum class SearchSchedule {
+  /*
+   * Improve the whole pool with a fixed number of V-cycles
+   */
+  VCycle,
+
+  /*
+   * Recombine pairs of solutions on the clusters where they agree,
+   * the offspring replacing the worst solution of the pool
+   */
+  Memetic
+};
+
+std::istream & operator>>(std::istream &, SearchSchedule&);
+std::ostream & operator<<(std::ostream &, const SearchSchedule&);
+
+std::istream & operator>>(std::istream &, ValidationLevel&);
+std::ostream & operator<<(std::ostream &, const ValidationLevel&);
+
+// Defaults are the same as the command line
 struct PartitioningParams {
-  int verbosity;
-  std::size_t seed;
-  ObjectiveType objective;
+  int verbosity = 1;
+  std::size_t seed = 0;
+  ObjectiveType objective = ObjectiveType::Soed;
+  ValidationLevel validation = ValidationLevel::Cheap;
 
   // V-cycling and solution pool
-  int nSolutions;
-  int nCycles;
+  int nSolutions = 32;
+  int nCycles = 1;
+  InitialPlacement initialPlacement = InitialPlacement::Random;
+  SearchSchedule schedule = SearchSchedule::VCycle;
+  int nGenerations = 32;
+
+  // Pool pruning: relative margin to the best objective, and fraction of the freed budget given to the remaining solutions
+  double pruningMargin = 0.0;
+  double pruningReallocation = 0.0;
+
+  // Recursive bisection
+  bool recursiveBisection = false;
+  bool recursiveBisectionRefinement = false;
 
   // Coarsening options
-  double minCoarseningFactor;
-  double maxCoarseningFactor;
-  Index minCoarseningNodes;
+  double minCoarseningFactor = 1.2;
+  double maxCoarseningFactor = 3.0;
+  Index minCoarseningNodes = 50;
 
   // Local search options
-  double movesPerElement;
+  double movesPerElement = 8.0;
+
+  // Time limit in seconds; no limit if not positive
+  double timeLimit = 0.0;
+
+  // Checkpoint written after each cycle, and whether to resume from it
+  std::string checkpointFile;
+  bool resume = false;
+
+  // Island model: number of worker processes, and cycles between two exchanges
+  int nIslands = 1;
+  int migrationInterval = 1;
 
-  // Problem statistics
-  Index nNodes;
-  Index nHedges;
-  Index nPins;
-  Index nParts;
+  // Problem statistics, filled from the hypergraph
+  Index nNodes = 0;
+  Index nHedges = 0;
+  Offset nPins = 0;
+  Index nParts = 0;
 
   bool isRatioObj() const;
   bool isDaisyChainObj() const;
@@ -0,0 +1,55 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_PROFILER_HH
+#define MINIPART_PROFILER_HH
+
+#include "common.hh"
+#include "config.hh"
+
+/**
+ * Scoped timers aggregated per phase and per level, enabled with the MINIPART_PROFILING build option
+ *
+ * Scopes nest: the self time of a phase excludes the time of the phases it contains,
+ * and phases without an explicit level inherit the level of the enclosing scope.
+ * When disabled, the macros compile to nothing.
+ */
+#ifdef MINIPART_PROFILING
+
+#include <chrono>
+#include <iosfwd>
+
+namespace minipart {
+
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char *phase);
+  ProfileScope(const char *phase, Index level);
+  ~ProfileScope();
+
+ private:
+  void start(const char *phase, Index level);
+};
+
+// Read cycles, cache misses and branch misses with perf_event_open for each phase
+void enablePerfCounters();
+
+void printProfile(std::ostream &);
+
+} // End namespace minipart
+
+#define MINIPART_PROFILE_CONCAT_(a, b) a##b
+#define MINIPART_PROFILE_CONCAT(a, b) MINIPART_PROFILE_CONCAT_(a, b)
+#define MINIPART_PROFILE_SCOPE(phase) \
+  ::minipart::ProfileScope MINIPART_PROFILE_CONCAT(profileScope_, __LINE__)(phase)
+#define MINIPART_PROFILE_LEVEL_SCOPE(phase, level) \
+  ::minipart::ProfileScope MINIPART_PROFILE_CONCAT(profileScope_, __LINE__)(phase, level)
+
+#else
+
+#define MINIPART_PROFILE_SCOPE(phase)
+#define MINIPART_PROFILE_LEVEL_SCOPE(phase, level)
+
+#endif
+
+#endif
+
@@ -29,6 +29,9 @@ class Solution {
   void writeFile(const std::string &name) const;
   static Solution read(std::istream &);
   void write(std::ostream &) const;
+  // Binary format, selected with the .msb extension
+  static Solution readBinary(const char *begin, const char *end);
+  void writeBinary(std::ostream &) const;
 
   void checkConsistency() const;
 
@@ -0,0 +1,44 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_STOP_CONDITION_HH
+#define MINIPART_STOP_CONDITION_HH
+
+#include "common.hh"
+
+#include <chrono>
+#include <cstdint>
+
+namespace minipart {
+
+/**
+ * Cooperative stop of the optimization, after a time limit or on request
+ *
+ * The algorithms check it regularly and return the best solution found so far.
+ * A stop request applies to the optimizations running when it is made: each condition
+ * only sees the requests made after its creation, so that later runs in the same process start afresh.
+ */
+class StopCondition {
+ public:
+  // Time limit in seconds; no limit if not positive
+  explicit StopCondition(double timeLimit=0.0);
+
+  bool stop() const;
+
+  // Request all running optimizations to stop; safe to call from a signal handler
+  static void requestStop();
+  // Whether a stop was requested since the creation of this condition
+  bool stopRequested() const;
+
+  // Request a stop on SIGINT and SIGTERM; a second signal terminates the program
+  static void installSignalHandlers();
+
+ private:
+  std::uint64_t startRequests_;
+  bool hasDeadline_;
+  std::chrono::steady_clock::time_point deadline_;
+};
+
+} // End namespace minipart
+
+#endif
+
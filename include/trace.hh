@@ -0,0 +1,42 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#ifndef MINIPART_TRACE_HH
+#define MINIPART_TRACE_HH
+
+#include "common.hh"
+
+#include <string>
+
+namespace minipart {
+
+/**
+ * Timeline of the run in the Chrome trace-event format, for chrome://tracing or Perfetto
+ *
+ * Each thread records its events in its own buffer; the file is written by closeTrace()
+ */
+void openTrace(const std::string &name);
+void closeTrace();
+// Stop recording without writing the file, for child processes
+void disableTrace();
+bool traceEnabled();
+
+/**
+ * A complete event covering the lifetime of the object, with an optional integer argument
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(const char *name, const char *argName=nullptr, std::int64_t argValue=0);
+  ~TraceScope();
+
+ private:
+  const char *name_;
+  const char *argName_;
+  std::int64_t argValue_;
+  double start_;
+  bool enabled_;
+};
+
+} // End namespace minipart
+
+#endif
+
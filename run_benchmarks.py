@@ -8,6 +8,10 @@ import multiprocessing
 import pandas as pd
 import os.path
 import argparse
+import json
+
+# Preprocessed hypergraphs are shared between the runs
+MINIPART_CACHE = ["--cache", "minipart_cache"]
 
 MinipartParams  = namedtuple("MinipartParams", ["bench", "input_file", "output_file", "solver", "blocks", "imbalance", "objective", "v_cycles", "pool_size", "move_ratio", "seed"])
 MinipartResults = namedtuple("MinipartResults", ["objective_value", "cut", "connectivity", "max_degree"])
@@ -135,26 +139,18 @@ def list_params(args):
     return list_params_kahypar(args) + list_params_minipart(args)
 
 def extract_metrics(output, objective):
-    o = output.decode("utf-8")
-    cut = None
-    connectivity = None
-    max_degree = None
-    daisy_chain_distance = None
-    daisy_chain_max_degree = None
-    for l in o.splitlines():
-      spl = l.split(":")
-      if len(spl) >= 2:
-        if spl[0] == "Cut":
-          cut = int(spl[1])
-        elif spl[0] == "Connectivity":
-          connectivity = int(spl[1])
-        elif spl[0] == "Maximum degree":
-          max_degree = int(spl[1])
-        elif spl[0] == "Daisy-chain distance":
-          daisy_chain_distance = int(spl[1])
-        elif spl[0] == "Daisy-chain maximum degree":
-          daisy_chain_max_degree = int(spl[1])
-    assert cut is not None
+    # Metrics of the last solution reported in the event stream
+    metrics = None
+    for l in output.decode("utf-8").splitlines():
+      event = json.loads(l)
+      if event["event"] in ["initial", "final"]:
+        metrics = event
+    assert metrics is not None
+    cut = metrics["cut"]
+    connectivity = metrics.get("connectivity")
+    max_degree = metrics.get("max_degree")
+    daisy_chain_distance = metrics.get("daisy_chain_distance")
+    daisy_chain_max_degree = metrics.get("daisy_chain_max_degree")
     assert (connectivity is not None) == (max_degree is not None)
     assert daisy_chain_distance is None or (connectivity is not None)
     assert daisy_chain_max_degree is None or (connectivity is not None)
@@ -207,7 +203,7 @@ def run_benchmark_minipart(params):
         "--pool-size", str(params.pool_size),
         "--move-ratio", str(params.move_ratio),
         "-s", str(params.seed),
-        "-o", filename + ".gz"])
+        "-o", filename + ".gz"] + MINIPART_CACHE)
     # No saving the results, as a solution file is generated
 
 def run_benchmark_kahypar(params):
@@ -254,7 +250,9 @@ def eval_benchmark(params):
         "-e", str(100.0 * params.imbalance),
         "-g", objective_param,
         "-f", filename + ".gz",
-        "--no-solve"])
+        "--verbosity", "0",
+        "--events", "fd:1",
+        "--no-solve"] + MINIPART_CACHE)
     return extract_metrics(output, params.objective)
 
 def save_benchmark(params):
@@ -335,6 +333,32 @@ def gather_solver_results(solver):
     if df.shape[0] > 0:
         df.to_csv("report_routed_degree_" + solver + ".csv", index=False, float_format="%.2f")
 
+def measure_pin_compression(bench):
+    output = subprocess.check_output(["./minipart_bench",
+        "-i", bench,
+        "--compress-pins",
+        "--verbosity", "0",
+        "--events", "fd:1",
+        "--no-solve"] + MINIPART_CACHE)
+    for l in output.decode("utf-8").splitlines():
+      event = json.loads(l)
+      if event["event"] == "pin_compression":
+        return event
+    raise RuntimeError("No pin compression event for " + bench)
+
+def report_pin_compression(args):
+    if not args.pin_compression:
+        return
+    columns = ["bench", "plain_mb", "compressed_mb", "saved", "plain_ns_per_pin", "compressed_ns_per_pin"]
+    df = pd.DataFrame(columns=columns)
+    for i, bench in enumerate(list_benchs(args)):
+      event = measure_pin_compression(bench_to_input_file(args, bench))
+      plain = event["plain_bytes"]
+      compressed = event["compressed_bytes"]
+      df.loc[i] = [bench_to_name(bench), plain / 1.0e6, compressed / 1.0e6, 1.0 - compressed / plain,
+                   event["plain_ns_per_pin"], event["compressed_ns_per_pin"]]
+    df.to_csv("report_pin_compression.csv", index=False, float_format="%.2f")
+
 def gather_results(args):
     if args.gather_results:
         if args.kahypar:
@@ -350,9 +374,11 @@ parser.add_argument("--minipart", help="Run Minipart", action="store_true")
 parser.add_argument("--kahypar", help="Run Kahypar", action="store_true")
 parser.add_argument("--save_db", help="Save results to database", action="store_true")
 parser.add_argument("--gather_results", help="Save results as CSV", action="store_true")
+parser.add_argument("--pin_compression", help="Report the memory and traversal cost of compressed pins as CSV", action="store_true")
 args = parser.parse_args()
 
 run_benchmarks(args)
 save_results(args)
 gather_results(args)
+report_pin_compression(args)
 
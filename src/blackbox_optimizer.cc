@@ -5,26 +5,57 @@
 #include "incremental_objective.hh"
 #include "partitioning_params.hh"
 #include "local_search_optimizer.hh"
+#include "buffer_pool.hh"
+#include "parallel.hh"
+#include "checkpoint.hh"
+#include "island.hh"
+#include "event_log.hh"
+#include "profiler.hh"
+#include "trace.hh"
 
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <cmath>
 
 using namespace std;
 
 namespace minipart {
-BlackboxOptimizer::BlackboxOptimizer(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, mt19937 &rgen, vector<Solution> &solutions, Index level)
+BlackboxOptimizer::BlackboxOptimizer(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, mt19937 &rgen, BufferPool &pool, const StopCondition &stop, vector<Solution> &solutions, Index level)
 : hypergraph_(hypergraph)
 , params_(params)
 , objective_(objective)
 , rgen_(rgen)
+, pool_(pool)
+, stop_(stop)
 , solutions_(solutions)
-, level_(level) {
+, level_(level)
+, cycle_(0)
+, checkpointWriter_(nullptr)
+, migration_(nullptr)
+, resumed_(false) {
 }
 
 void BlackboxOptimizer::runInitialPlacement() {
+  if ((Index) solutions_.size() >= params_.nSolutions) return;
+  EventScope scope("initial_placement", level_, hypergraph_);
+  MINIPART_PROFILE_LEVEL_SCOPE("initial_placement", level_);
+  TraceScope trace("Initial placement", "level", level_);
+  switch (params_.initialPlacement) {
+    case InitialPlacement::Random:
+      runRandomPlacement();
+      break;
+    case InitialPlacement::Multilevel:
+      runMultilevelPlacement();
+      break;
+  }
+  objectives_.clear();
+}
+
+void BlackboxOptimizer::runRandomPlacement() {
   while ((Index) solutions_.size() < params_.nSolutions) {
     uniform_int_distribution<int> partDist(0, hypergraph_.nParts()-1);
     Solution solution(hypergraph_.nNodes(), hypergraph_.nParts());
@@ -35,6 +66,59 @@ void BlackboxOptimizer::runInitialPlacement() {
   }
 }
 
+void BlackboxOptimizer::runMultilevelPlacement() {
+  report("Multilevel placement", params_.nSolutions - solutions_.size());
+
+  vector<Hypergraph> levels;
+  vector<Solution> coarsenings;
+  computeClusteringLevels(Solution(hypergraph_.nNodes(), 1), levels, coarsenings);
+
+  // Partition the coarsest hypergraph randomly, then refine while uncoarsening
+  while ((Index) solutions_.size() < params_.nSolutions) {
+    const Hypergraph &coarsest = levels.empty() ? hypergraph_ : levels.back();
+    uniform_int_distribution<int> partDist(0, coarsest.nParts()-1);
+    Solution solution(coarsest.nNodes(), coarsest.nParts());
+    for (Index i = 0; i < coarsest.nNodes(); ++i) {
+      solution[i] = partDist(rgen_);
+    }
+    refineLevels(levels, coarsenings, solution);
+    solutions_.push_back(solution);
+  }
+}
+
+void BlackboxOptimizer::computeClusteringLevels(const Solution &classes, vector<Hypergraph> &levels, vector<Solution> &coarsenings) {
+  // Cluster the nodes until the hypergraph is small enough, with clusters much smaller than a block
+  int64_t clusterWeight = hypergraph_.totalNodeWeight() / max((Index) 1, params_.minCoarseningNodes * hypergraph_.nParts());
+  Index maxClusterWeight = max((int64_t) 1, min(clusterWeight, (int64_t) numeric_limits<Index>::max()));
+  Solution levelClasses = classes;
+  while (true) {
+    const Hypergraph &fine = levels.empty() ? hypergraph_ : levels.back();
+    if (fine.nNodes() < params_.minCoarseningNodes * fine.nParts()) break;
+    Solution coarsening = fine.computeHeavyEdgeClustering(rgen_, maxClusterWeight, levelClasses);
+    if (coarsening.nNodes() / (double) coarsening.nParts() < params_.minCoarseningFactor) break;
+    Hypergraph coarse = fine.coarsen(coarsening);
+    levelClasses = levelClasses.coarsen(coarsening);
+    coarsenings.push_back(coarsening);
+    levels.push_back(std::move(coarse));
+  }
+}
+
+void BlackboxOptimizer::refineLevels(const vector<Hypergraph> &levels, const vector<Solution> &coarsenings, Solution &solution) {
+  // The local search budget is scaled to the size of each level; the finest level is left to the caller
+  for (size_t l = levels.size(); l > 0; --l) {
+    const Hypergraph &level = levels[l-1];
+    PartitioningParams levelParams = params_;
+    levelParams.nNodes = level.nNodes();
+    levelParams.nHedges = level.nHedges();
+    levelParams.nPins = level.nPins();
+    unique_ptr<IncrementalObjective> inc = objective_.incremental(level, solution, &pool_);
+    LocalSearchOptimizer(*inc, levelParams, rgen_, stop_).run();
+    if (params_.validation == ValidationLevel::Full) inc->checkConsistency();
+    inc.reset();
+    solution = solution.uncoarsen(coarsenings[l-1]);
+  }
+}
+
 void BlackboxOptimizer::report(const string &step) const {
   report(step, solutions_.size());
 }
@@ -58,9 +142,10 @@ void BlackboxOptimizer::reportStartCycle() const {
 }
 
 void BlackboxOptimizer::reportEndCycle() const {
+  reportPool("cycle", cycle_ + 1);
   if (params_.verbosity >= 2) {
-    Solution solution = bestSolution();
-    vector<int64_t> obj = objective_.eval(hypergraph_, solution);
+    const vector<vector<int64_t> > &objectives = poolObjectives();
+    const vector<int64_t> &obj = *min_element(objectives.begin(), objectives.end());
     cout << "Objectives: ";
     for (size_t i = 0; i < obj.size(); ++i) {
       if (i > 0) cout << ", ";
@@ -70,6 +155,11 @@ void BlackboxOptimizer::reportEndCycle() const {
   }
 }
 
+void BlackboxOptimizer::reportPool(const char *event, Index cycle) const {
+  if (!eventLogEnabled()) return;
+  Event(event).add("cycle", cycle).add("objectives", poolObjectives()).emit();
+}
+
 void BlackboxOptimizer::reportStartSearch() const {
 }
 
@@ -79,37 +169,276 @@ void BlackboxOptimizer::reportEndSearch() const {
   }
 }
 
+namespace {
+Solution runProblem(const Hypergraph &hypergraph, const PartitioningParams &params, const vector<Solution> &initialSolutions, BufferPool &pool) {
+  if (hypergraph.nParts() <= 0) throw runtime_error("The blocks must be set up before partitioning");
+  PartitioningParams problemParams = params;
+  problemParams.nNodes = hypergraph.nNodes();
+  problemParams.nHedges = hypergraph.nHedges();
+  problemParams.nPins = hypergraph.nPins();
+  problemParams.nParts = hypergraph.nParts();
+  vector<Solution> solutions = initialSolutions;
+  for (Solution &solution : solutions) {
+    if (solution.nNodes() != hypergraph.nNodes())
+      throw runtime_error("Hypergraph and solutions must have the same number of nodes");
+    if (solution.nParts() > hypergraph.nParts())
+      throw runtime_error("The initial solution has more blocks than the hypergraph");
+    solution.resizeParts(hypergraph.nParts());
+  }
+  unique_ptr<Objective> objective = Objective::create(params.objective);
+  return BlackboxOptimizer::run(hypergraph, problemParams, *objective, solutions, pool);
+}
+} // End anonymous namespace
+
+Solution partition(const Hypergraph &hypergraph, const PartitioningParams &params, const vector<Solution> &initialSolutions) {
+  PartitioningContext context;
+  return context.partition(hypergraph, params, initialSolutions);
+}
+
+Solution partitionIslands(const Hypergraph &hypergraph, const PartitioningParams &params, const vector<Solution> &initialSolutions) {
+  BufferPool pool;
+  return runProblem(hypergraph, params, initialSolutions, pool);
+}
+
+PartitioningContext::PartitioningContext(Index nThreads)
+: nThreads_(nThreads) {
+  if (nThreads < 0) throw runtime_error("The number of threads must be non-negative");
+}
+
+Solution PartitioningContext::partition(const Hypergraph &hypergraph, const PartitioningParams &params, const vector<Solution> &initialSolutions) {
+  if (params.nIslands > 1) throw runtime_error("Islands fork worker processes and are not available from partition(); use partitionIslands()");
+  ThreadCountScope threads(nThreads_);
+  return runProblem(hypergraph, params, initialSolutions, pool_);
+}
+
 Solution BlackboxOptimizer::run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const vector<Solution> &solutions) {
+  BufferPool pool;
+  return run(hypergraph, params, objective, solutions, pool);
+}
+
+Solution BlackboxOptimizer::run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const vector<Solution> &solutions, BufferPool &pool) {
+  StopCondition stop(params.timeLimit);
+  Solution solution = run(hypergraph, params, objective, solutions, stop, pool);
+  if (params.verbosity >= 1 && stop.stop()) {
+    cout << "Search stopped early, returning the best solution found" << endl << endl;
+  }
+  return solution;
+}
+
+Solution BlackboxOptimizer::run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const vector<Solution> &solutions, const StopCondition &stop, BufferPool &pool) {
+  if (params.nIslands > 1) {
+    return runIslands(hypergraph, params, objective, solutions, stop, pool);
+  }
+  return run(hypergraph, params, objective, solutions, stop, nullptr, pool);
+}
+
+Solution BlackboxOptimizer::run(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const vector<Solution> &solutions, const StopCondition &stop, IslandMigration *migration, BufferPool &pool) {
+  if (params.recursiveBisection && hypergraph.nParts() > 2) {
+    if (!params.checkpointFile.empty()) throw runtime_error("Checkpoints are not supported with recursive bisection");
+    if (migration != nullptr) throw runtime_error("Islands are not supported with recursive bisection");
+    return runRecursiveBisection(hypergraph, params, objective, stop, pool);
+  }
+  if (params.resume && params.checkpointFile.empty()) throw runtime_error("A checkpoint file is required to resume");
   mt19937 rgen(params.seed);
   // Copy because modified in-place
   vector<Solution> sols = solutions;
-  BlackboxOptimizer opt(hypergraph, params, objective, rgen, sols, 0);
-  return opt.run();
+  BlackboxOptimizer opt(hypergraph, params, objective, rgen, pool, stop, sols, 0);
+  opt.migration_ = migration;
+  unique_ptr<CheckpointWriter> writer;
+  if (!params.checkpointFile.empty()) {
+    if (params.resume) opt.resume(Checkpoint::readFile(params.checkpointFile));
+    writer.reset(new CheckpointWriter(params.checkpointFile));
+    opt.checkpointWriter_ = writer.get();
+  }
+  Solution solution = opt.run();
+  if (writer) writer->wait();
+  return solution;
 }
 
 Solution BlackboxOptimizer::run() {
+  EventScope scope("search", level_, hypergraph_);
   reportStartSearch();
-  runInitialPlacement();
-  runLocalSearch();
-  for (cycle_ = 0; cycle_ < params_.nCycles; ++cycle_) {
-    reportStartCycle();
-    runVCycle();
-    reportEndCycle();
+  // A resumed search continues from the pool of the checkpoint
+  if (!resumed_) {
+    runInitialPlacement();
+    runLocalSearch();
+    prunePool();
+    reportPool("pool", 0);
+  }
+  switch (params_.schedule) {
+    case SearchSchedule::VCycle:
+      for (; cycle_ < params_.nCycles; ++cycle_) {
+        if (stop_.stop()) break;
+        reportStartCycle();
+        runVCycle();
+        prunePool();
+        migrate();
+        writeCheckpoint();
+        reportEndCycle();
+      }
+      break;
+    case SearchSchedule::Memetic:
+      runMemetic();
+      break;
   }
   reportEndSearch();
 
   return bestSolution();
 }
 
+namespace {
+struct BisectionProblem {
+  // Hypergraph restricted to the nodes, with two blocks
+  Hypergraph hypergraph;
+  // Corresponding nodes in the original hypergraph
+  vector<Index> nodes;
+  // Range of final blocks
+  Index firstPart;
+  Index nParts;
+};
+
+vector<Index> bisectionCapacities(const Hypergraph &hypergraph, Index firstPart, Index nParts) {
+  // Each side gets the capacity of the final blocks it will contain
+  Index nWeights = hypergraph.nPartWeights();
+  vector<Index> capacities(2 * nWeights, 0);
+  for (Index p = firstPart; p < firstPart + nParts; ++p) {
+    Index side = p < firstPart + nParts / 2 ? 0 : 1;
+    for (Index i = 0; i < nWeights; ++i) {
+      capacities[side * nWeights + i] += hypergraph.partWeight(p, i);
+    }
+  }
+  return capacities;
+}
+
+size_t bisectionSeed(size_t seed, Index firstPart, Index nParts) {
+  // FNV hash, so that each subproblem has its own reproducible random generator
+  uint64_t magic = 1099511628211llu;
+  uint64_t ret = seed;
+  ret = (ret ^ (uint64_t) firstPart) * magic;
+  ret = (ret ^ (uint64_t) nParts) * magic;
+  return ret;
+}
+} // End anonymous namespace
+
+Solution BlackboxOptimizer::runRecursiveBisection(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const StopCondition &stop, BufferPool &pool) {
+  Solution solution(hypergraph.nNodes(), hypergraph.nParts());
+
+  vector<BisectionProblem> problems(1);
+  problems[0].hypergraph = hypergraph;
+  problems[0].hypergraph.setupBlocks(2, bisectionCapacities(hypergraph, 0, hypergraph.nParts()));
+  problems[0].nodes.resize(hypergraph.nNodes());
+  for (Index node = 0; node < hypergraph.nNodes(); ++node) {
+    problems[0].nodes[node] = node;
+  }
+  problems[0].firstPart = 0;
+  problems[0].nParts = hypergraph.nParts();
+
+  // Process the bisections level by level; subproblems of a level are independent
+  while (!problems.empty()) {
+    if (params.verbosity >= 2) {
+      cout << "Recursive bisection: " << problems.size() << " subproblems" << endl;
+    }
+    vector<BisectionProblem> children(2 * problems.size());
+    Index nProblems = problems.size();
+    parallelChunks(nProblems, min(nThreads(), nProblems), [&](Index, Index b, Index e) {
+      for (Index i = b; i < e; ++i) {
+        const BisectionProblem &problem = problems[i];
+        PartitioningParams subParams = params;
+        subParams.verbosity = 0;
+        subParams.seed = bisectionSeed(params.seed, problem.firstPart, problem.nParts);
+        subParams.recursiveBisection = false;
+        subParams.nNodes = problem.hypergraph.nNodes();
+        subParams.nHedges = problem.hypergraph.nHedges();
+        subParams.nPins = problem.hypergraph.nPins();
+        subParams.nParts = 2;
+        Solution bisection = run(problem.hypergraph, subParams, objective, vector<Solution>(), stop, pool);
+
+        for (Index side = 0; side < 2; ++side) {
+          BisectionProblem &child = children[2 * i + side];
+          child.firstPart = side == 0 ? problem.firstPart : problem.firstPart + problem.nParts / 2;
+          child.nParts = side == 0 ? problem.nParts / 2 : problem.nParts - problem.nParts / 2;
+          for (Index node = 0; node < bisection.nNodes(); ++node) {
+            if (bisection[node] == side) child.nodes.push_back(problem.nodes[node]);
+          }
+          if (child.nParts >= 2 && child.nodes.size() >= 2) {
+            child.hypergraph = problem.hypergraph.subHypergraph(bisection, side);
+            child.hypergraph.setupBlocks(2, bisectionCapacities(hypergraph, child.firstPart, child.nParts));
+          }
+        }
+      }
+    });
+
+    // Assign the final blocks, and keep the subproblems that need further bisection
+    problems.clear();
+    for (BisectionProblem &child : children) {
+      for (Index node : child.nodes) {
+        solution[node] = child.firstPart;
+      }
+      if (child.nParts >= 2 && child.nodes.size() >= 2) {
+        problems.push_back(std::move(child));
+      }
+    }
+  }
+
+  if (params.recursiveBisectionRefinement) {
+    if (params.verbosity >= 2) {
+      cout << "K-way refinement" << endl;
+    }
+    mt19937 rgen(params.seed);
+    unique_ptr<IncrementalObjective> inc = objective.incremental(hypergraph, solution, &pool);
+    LocalSearchOptimizer(*inc, params, rgen, stop).run();
+    if (params.validation == ValidationLevel::Full) inc->checkConsistency();
+  }
+
+  return solution;
+}
+
+namespace {
+size_t islandSeed(size_t seed, Index island) {
+  // FNV hash, so that each island has its own reproducible random generator
+  uint64_t magic = 1099511628211llu;
+  uint64_t ret = seed;
+  ret = (ret ^ (uint64_t) island) * magic;
+  return ret;
+}
+} // End anonymous namespace
+
+Solution BlackboxOptimizer::runIslands(const Hypergraph &hypergraph, const PartitioningParams &params, const Objective &objective, const vector<Solution> &solutions, const StopCondition &stop, BufferPool &pool) {
+  if (!params.checkpointFile.empty()) throw runtime_error("Checkpoints are not supported with islands");
+  // The workers share the threads, instead of each using all of them
+  Index islandThreads = max((Index) 1, nThreads() / params.nIslands);
+  IslandCoordinator coordinator(params.nIslands, [&](Index island, IslandMigration &migration) {
+    ThreadCountScope threads(islandThreads);
+    PartitioningParams islandParams = params;
+    islandParams.verbosity = 0;
+    // Only the coordinator writes events and traces
+    closeEventLog();
+    disableTrace();
+    islandParams.seed = islandSeed(params.seed, island);
+    return run(hypergraph, islandParams, objective, solutions, stop, &migration, pool);
+  }, params.migrationInterval);
+  return coordinator.run(hypergraph, objective, params.verbosity);
+}
+
 Solution BlackboxOptimizer::bestSolution() const {
   assert (!solutions_.empty());
-  size_t best = 0;
-  for (size_t i = 1; i < solutions_.size(); ++i) {
-    if (objective_.eval(hypergraph_, solutions_[i]) < objective_.eval(hypergraph_, solutions_[best])) {
-      best = i;
-    }
+  const vector<vector<int64_t> > &objectives = poolObjectives();
+  return solutions_[min_element(objectives.begin(), objectives.end()) - objectives.begin()];
+}
+
+const vector<vector<int64_t> > &BlackboxOptimizer::poolObjectives() const {
+  // Each solution is evaluated once until the pool is modified
+  if (objectives_.size() != solutions_.size()) {
+    TraceScope trace("Pool evaluation", "solutions", solutions_.size());
+    Index nSolutions = solutions_.size();
+    objectives_.assign(nSolutions, vector<int64_t>());
+    parallelChunks(nSolutions, nChunks(nSolutions, 1), [&](Index, Index b, Index e) {
+      for (Index i = b; i < e; ++i) {
+        objectives_[i] = objective_.eval(hypergraph_, solutions_[i]);
+      }
+    });
   }
-  return solutions_[best];
+  return objectives_;
 }
 
 namespace {
@@ -150,6 +479,7 @@ class SolutionComparer {
 } // End anonymous namespace
 
 Solution BlackboxOptimizer::computeCoarsening(const vector<Solution> &solutions) {
+  MINIPART_PROFILE_SCOPE("compute_coarsening");
   assert (solutions.size() >= 1);
   Index nNodes = solutions.front().nNodes();
   unordered_map<Index, Index, SolutionHasher, SolutionComparer> coarseningMap(nNodes, SolutionHasher(solutions), SolutionComparer(solutions));
@@ -170,6 +500,16 @@ Solution BlackboxOptimizer::computeCoarsening(const vector<Solution> &solutions)
   return Solution(coarsening);
 }
 
+uint64_t BlackboxOptimizer::hashSolution(const Solution &solution) {
+  // FNV hash
+  uint64_t magic = 1099511628211llu;
+  uint64_t ret = 0;
+  for (Index node = 0; node < solution.nNodes(); ++node) {
+    ret = (ret ^ (uint64_t)solution[node]) * magic;
+  }
+  return ret;
+}
+
 namespace {
 
 class CoarseningComparer {
@@ -197,18 +537,28 @@ class CoarseningComparer {
 } // End anonymous namespace
 
 void BlackboxOptimizer::runLocalSearch() {
+  EventScope scope("local_search", level_, hypergraph_);
+  MINIPART_PROFILE_LEVEL_SCOPE("local_search", level_);
+  TraceScope trace("Pool local search", "level", level_);
   report ("Local search");
   for (Solution &solution : solutions_) {
-    unique_ptr<IncrementalObjective> inc = objective_.incremental(hypergraph_, solution);
-    LocalSearchOptimizer(*inc, params_, rgen_).run();
-    inc->checkConsistency();
+    // After a stop, the remaining solutions are kept as they are rather than set up for nothing
+    if (stop_.stop()) break;
+    unique_ptr<IncrementalObjective> inc = objective_.incremental(hypergraph_, solution, &pool_);
+    LocalSearchOptimizer(*inc, params_, rgen_, stop_).run();
+    if (params_.validation == ValidationLevel::Full) inc->checkConsistency();
   }
+  objectives_.clear();
 }
 
 void BlackboxOptimizer::runVCycle() {
   checkConsistency();
 
+  if (stop_.stop()) return;
   if (hypergraph_.nNodes() < params_.minCoarseningNodes * hypergraph_.nParts()) return;
+  EventScope scope("v_cycle", level_, hypergraph_);
+  MINIPART_PROFILE_LEVEL_SCOPE("v_cycle", level_);
+  TraceScope trace("V-cycle", "level", level_);
   report ("V-cycle step");
 
   // Pick the best number of solutions for the coarsening
@@ -228,21 +578,224 @@ void BlackboxOptimizer::runVCycle() {
   for (size_t i = 0; i <= coarseningIndex; ++i) {
     cSolutions.emplace_back(solutions_[i].coarsen(coarsening));
   }
-  BlackboxOptimizer nextLevel(cHypergraph, params_, objective_, rgen_, cSolutions, level_+1);
+  BlackboxOptimizer nextLevel(cHypergraph, params_, objective_, rgen_, pool_, stop_, cSolutions, level_+1);
   nextLevel.runLocalSearch();
   nextLevel.runVCycle();
   report("Refinement", coarseningIndex + 1);
   for (size_t i = 0; i <= coarseningIndex; ++i) {
-    solutions_[i] = cSolutions[i].uncoarsen(coarsening);
-    unique_ptr<IncrementalObjective> inc = objective_.incremental(hypergraph_, solutions_[i]);
-    LocalSearchOptimizer(*inc, params_, rgen_).run();
-    inc->checkConsistency();
+    {
+      MINIPART_PROFILE_SCOPE("uncoarsen");
+      solutions_[i] = cSolutions[i].uncoarsen(coarsening);
+    }
+    if (stop_.stop()) continue;
+    MINIPART_PROFILE_SCOPE("refinement");
+    TraceScope trace("Refinement", "solution", i);
+    unique_ptr<IncrementalObjective> inc = objective_.incremental(hypergraph_, solutions_[i], &pool_);
+    LocalSearchOptimizer(*inc, params_, rgen_, stop_).run();
+    if (params_.validation == ValidationLevel::Full) inc->checkConsistency();
   }
+  objectives_.clear();
   checkConsistency();
 }
 
+namespace {
+/**
+ * Whether a solution trails the best one by more than the relative margin
+ *
+ * The margin applies to each component separately: the solution is dropped if any component exceeds
+ * the value of the best solution increased by the margin. A component that is zero for the best solution
+ * tolerates no increase, so that a solution violating the constraints is dropped if the best one is feasible.
+ */
+bool outsideMargin(const vector<int64_t> &objective, const vector<int64_t> &best, double margin) {
+  for (size_t i = 0; i < objective.size(); ++i) {
+    if (objective[i] > best[i] + (int64_t) ceil(margin * abs(best[i]))) return true;
+  }
+  return false;
+}
+} // End anonymous namespace
+
+void BlackboxOptimizer::prunePool() {
+  TraceScope trace("Pruning");
+  if (params_.pruningMargin <= 0.0 || solutions_.size() <= 1) return;
+  vector<vector<int64_t> > objectives;
+  vector<uint64_t> hashes;
+  for (Solution &solution : solutions_) {
+    objectives.push_back(objective_.eval(hypergraph_, solution));
+    hashes.push_back(hashSolution(solution));
+  }
+
+  // Solutions worse than the best one by more than the margin are dropped
+  vector<int64_t> best = *min_element(objectives.begin(), objectives.end());
+
+  vector<Solution> kept;
+  vector<uint64_t> keptHashes;
+  for (size_t i = 0; i < solutions_.size(); ++i) {
+    if (outsideMargin(objectives[i], best, params_.pruningMargin)) continue;
+    // Identical solutions are only kept once
+    bool duplicate = false;
+    for (size_t j = 0; j < kept.size() && !duplicate; ++j) {
+      if (keptHashes[j] != hashes[i]) continue;
+      duplicate = true;
+      for (Index node = 0; node < hypergraph_.nNodes() && duplicate; ++node) {
+        duplicate = kept[j][node] == solutions_[i][node];
+      }
+    }
+    if (duplicate) continue;
+    kept.push_back(solutions_[i]);
+    keptHashes.push_back(hashes[i]);
+  }
+
+  size_t nPruned = solutions_.size() - kept.size();
+  if (nPruned == 0) return;
+  objectives_.clear();
+  params_.movesPerElement *= 1.0 + params_.pruningReallocation * nPruned / kept.size();
+  solutions_ = kept;
+  if (eventLogEnabled()) {
+    Event("prune").add("pruned", (Index) nPruned).add("remaining", (Index) solutions_.size()).emit();
+  }
+  if (params_.verbosity >= 2) {
+    cout << "Pruned " << nPruned << " solutions, " << solutions_.size() << " remaining" << endl;
+  }
+}
+
+void BlackboxOptimizer::resume(const Checkpoint &checkpoint) {
+  if (checkpoint.nNodes != hypergraph_.nNodes()) throw runtime_error("Hypergraph and checkpoint must have the same number of nodes");
+  if (checkpoint.nParts != hypergraph_.nParts()) throw runtime_error("Hypergraph and checkpoint must have the same number of partitions");
+  if (checkpoint.solutions.empty()) throw runtime_error("Empty solution pool in the checkpoint");
+  solutions_ = checkpoint.solutions;
+  objectives_ = checkpoint.objectives;
+  cycle_ = checkpoint.cycle;
+  params_.movesPerElement = checkpoint.movesPerElement;
+  istringstream ss(checkpoint.rgenState);
+  ss >> rgen_;
+  if (ss.fail()) throw runtime_error("Invalid random generator state in the checkpoint");
+  resumed_ = true;
+}
+
+void BlackboxOptimizer::writeCheckpoint() {
+  // An interrupted cycle leaves the pool in a state that cannot be resumed exactly
+  if (checkpointWriter_ == nullptr || stop_.stop()) return;
+  Checkpoint checkpoint;
+  checkpoint.nNodes = hypergraph_.nNodes();
+  checkpoint.nParts = hypergraph_.nParts();
+  checkpoint.cycle = cycle_ + 1;
+  checkpoint.movesPerElement = params_.movesPerElement;
+  ostringstream ss;
+  ss << rgen_;
+  checkpoint.rgenState = ss.str();
+  checkpoint.solutions = solutions_;
+  poolObjectives();
+  checkpoint.objectives = objectives_;
+  checkpointWriter_->write(std::move(checkpoint));
+}
+
+void BlackboxOptimizer::migrate() {
+  // The exchange is skipped on a stop, and the worker sends its final solution instead
+  if (migration_ == nullptr || stop_.stop() || !migration_->isMigrationCycle(cycle_)) return;
+  Solution migrant = migration_->exchange(bestSolution());
+  poolObjectives();
+  // The migrant replaces the worst solution of the pool
+  vector<int64_t> obj = objective_.eval(hypergraph_, migrant);
+  size_t worst = max_element(objectives_.begin(), objectives_.end()) - objectives_.begin();
+  if (obj <= objectives_[worst] && !isDuplicate(migrant, obj, objectives_)) {
+    solutions_[worst] = migrant;
+    objectives_[worst] = obj;
+  }
+}
+
+void BlackboxOptimizer::runMemetic() {
+  if (solutions_.size() < 2) return;
+  poolObjectives();
+  vector<vector<int64_t> > &objectives = objectives_;
+
+  for (; cycle_ < params_.nGenerations; ++cycle_) {
+    if (stop_.stop()) break;
+    size_t p1 = selectParent(objectives);
+    size_t p2 = selectParent(objectives);
+    while (p2 == p1) p2 = selectParent(objectives);
+    if (objectives[p2] < objectives[p1]) swap(p1, p2);
+
+    Solution offspring = recombine(solutions_[p1], solutions_[p2]);
+    vector<int64_t> obj = objective_.eval(hypergraph_, offspring);
+
+    // The offspring replaces the worst solution of the pool; duplicates are rejected to keep the pool diverse
+    size_t worst = max_element(objectives.begin(), objectives.end()) - objectives.begin();
+    bool accepted = obj <= objectives[worst] && !isDuplicate(offspring, obj, objectives);
+    if (accepted) {
+      solutions_[worst] = offspring;
+      objectives[worst] = obj;
+    }
+    if (eventLogEnabled()) {
+      Event("generation").add("cycle", cycle_ + 1).add("objective", obj).add("accepted", (Index) accepted).emit();
+    }
+    if (params_.verbosity >= 2) {
+      cout << "Generation #" << cycle_ + 1 << ": ";
+      for (size_t i = 0; i < obj.size(); ++i) {
+        if (i > 0) cout << ", ";
+        cout << obj[i];
+      }
+      cout << endl;
+    }
+    migrate();
+    writeCheckpoint();
+  }
+  checkConsistency();
+}
+
+bool BlackboxOptimizer::isDuplicate(const Solution &solution, const vector<int64_t> &obj, const vector<vector<int64_t> > &objectives) const {
+  for (size_t i = 0; i < solutions_.size(); ++i) {
+    if (objectives[i] != obj) continue;
+    bool same = true;
+    for (Index node = 0; node < solution.nNodes() && same; ++node) {
+      same = solution[node] == solutions_[i][node];
+    }
+    if (same) return true;
+  }
+  return false;
+}
+
+size_t BlackboxOptimizer::selectParent(const vector<vector<int64_t> > &objectives) {
+  // Binary tournament
+  uniform_int_distribution<size_t> dist(0, objectives.size() - 1);
+  size_t s1 = dist(rgen_);
+  size_t s2 = dist(rgen_);
+  return objectives[s2] < objectives[s1] ? s2 : s1;
+}
+
+Solution BlackboxOptimizer::recombine(const Solution &parent1, const Solution &parent2) {
+  EventScope scope("recombination", level_, hypergraph_);
+  MINIPART_PROFILE_LEVEL_SCOPE("recombination", level_);
+  TraceScope trace("Recombination", "level", level_);
+  report("Recombination", 2);
+
+  // Cluster only the nodes where the parents agree, so that both parents are valid at every level
+  vector<Hypergraph> levels;
+  vector<Solution> coarsenings;
+  computeClusteringLevels(computeCoarsening({parent1, parent2}), levels, coarsenings);
+
+  // Solve the coarse problem from both parents with the full local search budget, keep the best one
+  const Hypergraph &coarsest = levels.empty() ? hypergraph_ : levels.back();
+  vector<Solution> cSolutions = {parent1, parent2};
+  for (Solution &solution : cSolutions) {
+    for (const Solution &coarsening : coarsenings) {
+      solution = solution.coarsen(coarsening);
+    }
+  }
+  BlackboxOptimizer coarseLevel(coarsest, params_, objective_, rgen_, pool_, stop_, cSolutions, level_+1);
+  coarseLevel.runLocalSearch();
+  Solution offspring = coarseLevel.bestSolution();
+
+  // Refine while uncoarsening
+  refineLevels(levels, coarsenings, offspring);
+  unique_ptr<IncrementalObjective> inc = objective_.incremental(hypergraph_, offspring, &pool_);
+  LocalSearchOptimizer(*inc, params_, rgen_, stop_).run();
+  if (params_.validation == ValidationLevel::Full) inc->checkConsistency();
+  return offspring;
+}
+
 void BlackboxOptimizer::checkConsistency() const {
-  hypergraph_.checkConsistency();
+  if (params_.validation == ValidationLevel::Off) return;
+  hypergraph_.checkConsistency(params_.validation);
   for (const Solution &solution : solutions_) {
     if (hypergraph_.nNodes() != solution.nNodes())
       throw runtime_error("Hypergraph and solutions must have the same number of nodes");
@@ -0,0 +1,52 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "buffer_pool.hh"
+
+using namespace std;
+
+namespace minipart {
+
+vector<Index> BufferPool::get(size_t size, Index value) {
+  vector<Index> ret;
+  {
+    lock_guard<mutex> lock(mutex_);
+    // Smallest buffer that is large enough, or the largest one otherwise
+    size_t best = buffers_.size();
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      size_t cap = buffers_[i].capacity();
+      if (best == buffers_.size()) {
+        best = i;
+        continue;
+      }
+      size_t bestCap = buffers_[best].capacity();
+      bool fits = cap >= size;
+      bool bestFits = bestCap >= size;
+      if ((fits && (!bestFits || cap < bestCap)) || (!fits && !bestFits && cap > bestCap)) {
+        best = i;
+      }
+    }
+    if (best != buffers_.size()) {
+      ret.swap(buffers_[best]);
+      buffers_[best].swap(buffers_.back());
+      buffers_.pop_back();
+    }
+  }
+  ret.assign(size, value);
+  return ret;
+}
+
+void BufferPool::recycle(vector<Index> &&buffer) {
+  if (buffer.capacity() == 0) return;
+  lock_guard<mutex> lock(mutex_);
+  if (buffers_.size() >= maxBuffers_) return;
+  buffers_.emplace_back(move(buffer));
+  buffers_.back().clear();
+}
+
+size_t BufferPool::nBuffers() const {
+  lock_guard<mutex> lock(mutex_);
+  return buffers_.size();
+}
+
+} // End namespace minipart
+
@@ -0,0 +1,143 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "checkpoint.hh"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+// Fields are stored in the native byte order
+const char checkpointMagic[4] = {'M', 'P', 'C', 'K'};
+const uint32_t checkpointVersion = 1;
+
+template<typename T>
+void writeValue(ostream &s, T value) {
+  s.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(istream &s) {
+  T value;
+  s.read(reinterpret_cast<char*>(&value), sizeof(T));
+  if (s.fail()) throw runtime_error("Truncated checkpoint file");
+  return value;
+}
+
+Index readCount(istream &s) {
+  Index n = readValue<Index>(s);
+  if (n < 0) throw runtime_error("Invalid checkpoint file");
+  return n;
+}
+} // End anonymous namespace
+
+Checkpoint Checkpoint::readFile(const string &name) {
+  ifstream s(name, ios_base::in | ios_base::binary);
+  if (s.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
+  char magic[4];
+  s.read(magic, 4);
+  if (s.fail() || memcmp(magic, checkpointMagic, 4) != 0) {
+    throw runtime_error("File \"" + name + "\" is not a checkpoint");
+  }
+  if (readValue<uint32_t>(s) != checkpointVersion) {
+    throw runtime_error("Unsupported checkpoint version in \"" + name + "\"");
+  }
+
+  Checkpoint ret;
+  ret.nNodes = readCount(s);
+  ret.nParts = readCount(s);
+  ret.cycle = readCount(s);
+  ret.movesPerElement = readValue<double>(s);
+  ret.rgenState.resize(readCount(s));
+  s.read(&ret.rgenState[0], ret.rgenState.size());
+
+  Index nSolutions = readCount(s);
+  for (Index i = 0; i < nSolutions; ++i) {
+    Solution solution(ret.nNodes, ret.nParts);
+    for (Index node = 0; node < ret.nNodes; ++node) {
+      solution[node] = readValue<Index>(s);
+      if (solution[node] < 0 || solution[node] >= ret.nParts) {
+        throw runtime_error("Invalid solution in checkpoint file");
+      }
+    }
+    ret.solutions.push_back(solution);
+  }
+  Index nObjectives = readCount(s);
+  for (Index i = 0; i < nObjectives; ++i) {
+    vector<int64_t> obj(readCount(s));
+    for (int64_t &o : obj) {
+      o = readValue<int64_t>(s);
+    }
+    ret.objectives.push_back(obj);
+  }
+  return ret;
+}
+
+void Checkpoint::writeFile(const string &name) const {
+  // Write to a temporary file first, so that a partial checkpoint never replaces a valid one
+  string tmpName = name + ".tmp";
+  {
+    ofstream s(tmpName, ios_base::out | ios_base::binary | ios_base::trunc);
+    if (s.fail()) throw runtime_error("Unable to open the file \"" + tmpName + "\"");
+    s.write(checkpointMagic, 4);
+    writeValue<uint32_t>(s, checkpointVersion);
+    writeValue<Index>(s, nNodes);
+    writeValue<Index>(s, nParts);
+    writeValue<Index>(s, cycle);
+    writeValue<double>(s, movesPerElement);
+    writeValue<Index>(s, rgenState.size());
+    s.write(rgenState.data(), rgenState.size());
+    writeValue<Index>(s, solutions.size());
+    for (const Solution &solution : solutions) {
+      for (Index node = 0; node < solution.nNodes(); ++node) {
+        writeValue<Index>(s, solution[node]);
+      }
+    }
+    writeValue<Index>(s, objectives.size());
+    for (const vector<int64_t> &obj : objectives) {
+      writeValue<Index>(s, obj.size());
+      for (int64_t o : obj) {
+        writeValue<int64_t>(s, o);
+      }
+    }
+    s.flush();
+    if (s.fail()) throw runtime_error("Unable to write the file \"" + tmpName + "\"");
+  }
+  if (rename(tmpName.c_str(), name.c_str()) != 0) {
+    throw runtime_error("Unable to write the file \"" + name + "\"");
+  }
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  if (thread_.joinable()) thread_.join();
+}
+
+void CheckpointWriter::write(Checkpoint &&checkpoint) {
+  wait();
+  string name = name_;
+  exception_ptr &error = error_;
+  thread_ = thread([name, &error](Checkpoint c) {
+    try {
+      c.writeFile(name);
+    } catch (...) {
+      error = current_exception();
+    }
+  }, std::move(checkpoint));
+}
+
+void CheckpointWriter::wait() {
+  if (thread_.joinable()) thread_.join();
+  if (error_) {
+    exception_ptr e = error_;
+    error_ = nullptr;
+    rethrow_exception(e);
+  }
+}
+
+} // End namespace minipart
+
@@ -0,0 +1,199 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "event_log.hh"
+#include "hypergraph.hh"
+
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+// Lines are accumulated and written when the buffer is large enough
+const size_t eventBufferSize = 1 << 16;
+
+mutex eventMutex;
+atomic<int> eventFd(-1);
+bool ownsEventFd = false;
+string eventBuffer;
+chrono::steady_clock::time_point eventStart;
+
+void flushEvents() {
+  const char *data = eventBuffer.data();
+  size_t size = eventBuffer.size();
+  while (size > 0) {
+    ssize_t n = ::write(eventFd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    data += n;
+    size -= n;
+  }
+  eventBuffer.clear();
+}
+
+double elapsedSeconds(chrono::steady_clock::time_point since) {
+  return chrono::duration<double>(chrono::steady_clock::now() - since).count();
+}
+
+void appendEscaped(string &s, const char *value) {
+  s += '"';
+  for (const char *c = value; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      s += '\\';
+      s += *c;
+    }
+    else if ((unsigned char) *c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned) *c);
+      s += buf;
+    }
+    else {
+      s += *c;
+    }
+  }
+  s += '"';
+}
+} // End anonymous namespace
+
+void openEventLog(const string &destination) {
+  lock_guard<mutex> lock(eventMutex);
+  if (eventFd >= 0) throw runtime_error("The event log is already open");
+  if (destination.compare(0, 3, "fd:") == 0) {
+    eventFd = stoi(destination.substr(3));
+    ownsEventFd = false;
+  }
+  else {
+    eventFd = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (eventFd < 0) throw runtime_error("Unable to open the file \"" + destination + "\"");
+    ownsEventFd = true;
+  }
+  eventBuffer.reserve(eventBufferSize + 4096);
+  eventStart = chrono::steady_clock::now();
+}
+
+void flushEventLog() {
+  lock_guard<mutex> lock(eventMutex);
+  if (eventFd < 0) return;
+  flushEvents();
+}
+
+void closeEventLog() {
+  lock_guard<mutex> lock(eventMutex);
+  if (eventFd < 0) return;
+  flushEvents();
+  if (ownsEventFd) ::close(eventFd);
+  eventFd = -1;
+}
+
+bool eventLogEnabled() {
+  return eventFd >= 0;
+}
+
+Event::Event(const char *type) {
+  line_ = "{\"event\":";
+  appendEscaped(line_, type);
+  add("t", elapsedSeconds(eventStart));
+}
+
+void Event::addKey(const char *key) {
+  line_ += ',';
+  appendEscaped(line_, key);
+  line_ += ':';
+}
+
+Event &Event::add(const char *key, Index value) {
+  return add(key, (int64_t) value);
+}
+
+Event &Event::add(const char *key, int64_t value) {
+  addKey(key);
+  line_ += to_string(value);
+  return *this;
+}
+
+Event &Event::add(const char *key, double value) {
+  addKey(key);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.6g", value);
+  line_ += buf;
+  return *this;
+}
+
+Event &Event::add(const char *key, const char *value) {
+  addKey(key);
+  appendEscaped(line_, value);
+  return *this;
+}
+
+Event &Event::add(const char *key, const string &value) {
+  return add(key, value.c_str());
+}
+
+Event &Event::add(const char *key, const vector<int64_t> &values) {
+  addKey(key);
+  line_ += '[';
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) line_ += ',';
+    line_ += to_string(values[i]);
+  }
+  line_ += ']';
+  return *this;
+}
+
+Event &Event::add(const char *key, const vector<vector<int64_t> > &values) {
+  addKey(key);
+  line_ += '[';
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) line_ += ',';
+    line_ += '[';
+    for (size_t j = 0; j < values[i].size(); ++j) {
+      if (j > 0) line_ += ',';
+      line_ += to_string(values[i][j]);
+    }
+    line_ += ']';
+  }
+  line_ += ']';
+  return *this;
+}
+
+void Event::emit() {
+  line_ += "}\n";
+  lock_guard<mutex> lock(eventMutex);
+  if (eventFd < 0) return;
+  eventBuffer += line_;
+  if (eventBuffer.size() >= eventBufferSize) flushEvents();
+}
+
+EventScope::EventScope(const char *phase, Index level, const Hypergraph &hypergraph)
+: phase_(phase)
+, level_(level) {
+  if (!eventLogEnabled()) return;
+  start_ = chrono::steady_clock::now();
+  Event("enter")
+    .add("phase", phase_)
+    .add("level", level_)
+    .add("nodes", hypergraph.nNodes())
+    .add("hedges", hypergraph.nHedges())
+    .add("pins", hypergraph.nPins())
+    .emit();
+}
+
+EventScope::~EventScope() {
+  if (!eventLogEnabled()) return;
+  Event("exit")
+    .add("phase", phase_)
+    .add("level", level_)
+    .add("duration", elapsedSeconds(start_))
+    .emit();
+}
+
+} // End namespace minipart
+
@@ -0,0 +1,215 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "gzip.hh"
+#include "parallel.hh"
+
+#include <vector>
+#include <stdexcept>
+#include <zlib.h>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+Index gzipLevel = 6;
+
+// Uncompressed size of a member
+const size_t blockSize = 1 << 20;
+
+// Member header: fixed fields, then an extra field holding the size of the member
+const size_t headerSize = 20;
+const unsigned char flagExtra = 4;
+const char subfieldId[2] = {'M', 'P'};
+
+void writeLittleEndian(string &s, uint32_t value, int nBytes) {
+  for (int i = 0; i < nBytes; ++i) {
+    s.push_back((char) ((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint32_t readLittleEndian(const char *data, int nBytes) {
+  uint32_t ret = 0;
+  for (int i = 0; i < nBytes; ++i) {
+    ret |= (uint32_t) (unsigned char) data[i] << (8 * i);
+  }
+  return ret;
+}
+
+string compressMember(const char *begin, const char *end) {
+  z_stream stream = {};
+  if (deflateInit2(&stream, gzipLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw runtime_error("Unable to initialize the gzip compression");
+  }
+  string deflated(deflateBound(&stream, end - begin), '\0');
+  stream.next_in = (Bytef *) begin;
+  stream.avail_in = end - begin;
+  stream.next_out = (Bytef *) &deflated[0];
+  stream.avail_out = deflated.size();
+  int status = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) throw runtime_error("Gzip compression failed");
+  deflated.resize(stream.total_out);
+
+  string ret;
+  ret.reserve(headerSize + deflated.size() + 8);
+  ret += {'\x1f', '\x8b', '\x08', (char) flagExtra, 0, 0, 0, 0, 0, '\x03'};
+  writeLittleEndian(ret, 8, 2);
+  ret += {subfieldId[0], subfieldId[1]};
+  writeLittleEndian(ret, 4, 2);
+  writeLittleEndian(ret, headerSize + deflated.size() + 8, 4);
+  ret += deflated;
+  writeLittleEndian(ret, crc32(0, (const Bytef *) begin, end - begin), 4);
+  writeLittleEndian(ret, end - begin, 4);
+  return ret;
+}
+
+/**
+ * Split the stream into members if they all record their size
+ */
+bool splitMembers(const char *begin, const char *end, vector<const char *> &members) {
+  members.assign(1, begin);
+  const char *pos = begin;
+  while (pos != end) {
+    if (end - pos < (ptrdiff_t) headerSize + 8) return false;
+    if (pos[0] != '\x1f' || pos[1] != '\x8b' || pos[2] != '\x08' || pos[3] != (char) flagExtra) return false;
+    if (readLittleEndian(pos + 10, 2) != 8 || pos[12] != subfieldId[0] || pos[13] != subfieldId[1]) return false;
+    if (readLittleEndian(pos + 14, 2) != 4) return false;
+    uint32_t size = readLittleEndian(pos + 16, 4);
+    if (size < headerSize + 8 || size > (size_t) (end - pos)) return false;
+    pos += size;
+    members.push_back(pos);
+  }
+  return members.size() > 1;
+}
+
+void inflateMember(const char *begin, const char *end, char *out, size_t outSize) {
+  z_stream stream = {};
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) throw runtime_error("Unable to initialize the gzip decompression");
+  stream.next_in = (Bytef *) begin;
+  stream.avail_in = end - begin;
+  stream.next_out = (Bytef *) out;
+  stream.avail_out = outSize;
+  int status = inflate(&stream, Z_FINISH);
+  inflateEnd(&stream);
+  if (status != Z_STREAM_END || stream.avail_in != 0 || stream.avail_out != 0) {
+    throw runtime_error("Invalid gzip file");
+  }
+}
+
+string decompressParallel(const vector<const char *> &members) {
+  Index nMembers = members.size() - 1;
+  vector<size_t> offsets(nMembers + 1, 0);
+  for (Index i = 0; i < nMembers; ++i) {
+    offsets[i+1] = offsets[i] + readLittleEndian(members[i+1] - 4, 4);
+  }
+  string ret(offsets.back(), '\0');
+  parallelChunks(nMembers, nChunks(nMembers, 1), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      inflateMember(members[i], members[i+1], &ret[0] + offsets[i], offsets[i+1] - offsets[i]);
+    }
+  });
+  return ret;
+}
+
+string decompressSequential(const char *begin, const char *end) {
+  z_stream stream = {};
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) throw runtime_error("Unable to initialize the gzip decompression");
+  stream.next_in = (Bytef *) begin;
+  stream.avail_in = end - begin;
+  string ret;
+  char buffer[1 << 16];
+  while (true) {
+    stream.next_out = (Bytef *) buffer;
+    stream.avail_out = sizeof(buffer);
+    int status = inflate(&stream, Z_NO_FLUSH);
+    ret.append(buffer, sizeof(buffer) - stream.avail_out);
+    if (status == Z_STREAM_END) {
+      // Concatenated members
+      if (stream.avail_in == 0) break;
+      inflateReset(&stream);
+    }
+    else if (status != Z_OK) {
+      inflateEnd(&stream);
+      throw runtime_error(status == Z_BUF_ERROR ? "Truncated gzip file" : "Invalid gzip file");
+    }
+  }
+  inflateEnd(&stream);
+  return ret;
+}
+} // End anonymous namespace
+
+void setGzipLevel(Index level) {
+  if (level < 0 || level > 9) throw runtime_error("The gzip compression level must be between 0 and 9");
+  gzipLevel = level;
+}
+
+string gzipCompress(const char *begin, const char *end) {
+  Index nBlocks = max((size_t) 1, (end - begin + blockSize - 1) / blockSize);
+  vector<string> members(nBlocks);
+  parallelChunks(nBlocks, nChunks(nBlocks, 1), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      const char *blockBegin = begin + min((size_t) (end - begin), i * blockSize);
+      const char *blockEnd = begin + min((size_t) (end - begin), (i + 1) * blockSize);
+      members[i] = compressMember(blockBegin, blockEnd);
+    }
+  });
+  string ret;
+  size_t size = 0;
+  for (const string &member : members) size += member.size();
+  ret.reserve(size);
+  for (const string &member : members) ret += member;
+  return ret;
+}
+
+GzipOutputBuffer::GzipOutputBuffer(ostream &s)
+: s_(s)
+, buffer_(nThreads() * blockSize)
+, written_(false) {
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+GzipOutputBuffer::int_type GzipOutputBuffer::overflow(int_type c) {
+  compressBatch();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+void GzipOutputBuffer::finish() {
+  // An empty output is still a valid gzip stream
+  if (pptr() != pbase() || !written_) compressBatch();
+}
+
+void GzipOutputBuffer::compressBatch() {
+  const char *begin = pbase();
+  const char *end = pptr();
+  Index nBlocks = max((size_t) 1, (end - begin + blockSize - 1) / blockSize);
+  members_.resize(nBlocks);
+  parallelChunks(nBlocks, nChunks(nBlocks, 1), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      const char *blockBegin = begin + min((size_t) (end - begin), i * blockSize);
+      const char *blockEnd = begin + min((size_t) (end - begin), (i + 1) * blockSize);
+      members_[i] = compressMember(blockBegin, blockEnd);
+    }
+  });
+  for (const string &member : members_) {
+    s_.write(member.data(), member.size());
+  }
+  written_ = true;
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+string gzipDecompress(const char *begin, const char *end) {
+  vector<const char *> members;
+  if (splitMembers(begin, end, members)) {
+    return decompressParallel(members);
+  }
+  else {
+    return decompressSequential(begin, end);
+  }
+}
+
+} // End namespace minipart
@@ -1,13 +1,17 @@
 // Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
 
 #include "hypergraph.hh"
+#include "parallel.hh"
+#include "profiler.hh"
 
 #include <cassert>
 #include <algorithm>
 #include <stdexcept>
 #include <unordered_set>
-#include <unordered_map>
 #include <cmath>
+#include <limits>
+#include <atomic>
+#include <functional>
 
 using namespace std;
 
@@ -20,6 +24,7 @@ Hypergraph::Hypergraph(Index nodeWeights, Index hedgeWeights, Index partWeights)
   nNodeWeights_ = nodeWeights;
   nHedgeWeights_ = hedgeWeights;
   nPartWeights_ = partWeights;
+  pinsCompressed_ = false;
   totalNodeWeights_.assign(nodeWeights, 0);
   totalHedgeWeights_.assign(hedgeWeights, 0);
   totalPartWeights_.assign(partWeights, 0);
@@ -27,7 +32,71 @@ Hypergraph::Hypergraph(Index nodeWeights, Index hedgeWeights, Index partWeights)
   nodeBegin_.push_back(0);
 }
 
+Hypergraph Hypergraph::fromPins(Index nNodes, vector<Offset> hedgeBegin, vector<Index> hedgePins, vector<Index> nodeWeights, vector<Index> hedgeWeights) {
+  MINIPART_PROFILE_SCOPE("build");
+  if (nNodes < 0) throw runtime_error("Negative number of nodes");
+  if (hedgeBegin.empty()) hedgeBegin.push_back(0);
+  if ((Offset) hedgeBegin.size() - 1 > numeric_limits<Index>::max())
+    throw runtime_error("The number of hedges exceeds the range of the indices");
+  Index nHedges = hedgeBegin.size() - 1;
+  if (hedgeBegin.front() != 0) throw runtime_error("Hedge limits must start at 0");
+  if (hedgeBegin.back() != (Offset) hedgePins.size()) throw runtime_error("Hedge limits must end at the number of pins");
+  for (Index hedge = 0; hedge < nHedges; ++hedge) {
+    if (hedgeBegin[hedge] > hedgeBegin[hedge+1]) throw runtime_error("Hedge limits must be non-decreasing");
+  }
+  for (Index node : hedgePins) {
+    if (node < 0 || node >= nNodes) throw runtime_error("Invalid node value");
+  }
+
+  auto countWeights = [](const vector<Index> &weights, Index n, const char *what) -> Index {
+    if (weights.empty()) return 1;
+    if (n == 0 || weights.size() % n != 0)
+      throw runtime_error(string("The number of ") + what + " weights is not a multiple of the number of " + what + "s");
+    return weights.size() / n;
+  };
+  Index nNodeWeights = countWeights(nodeWeights, nNodes, "node");
+  Index nHedgeWeights = countWeights(hedgeWeights, nHedges, "hedge");
+  if (nodeWeights.empty()) nodeWeights.assign(nNodes, 1);
+  if (hedgeWeights.empty()) hedgeWeights.assign(nHedges, 1);
+
+  // Sort the pins of each hedge in place, then remove duplicates if there are any
+  vector<char> duplicates(nChunks(nHedges), 0);
+  parallelChunks(nHedges, duplicates.size(), [&](Index c, Index b, Index e) {
+    for (Index hedge = b; hedge < e; ++hedge) {
+      Index *begin = hedgePins.data() + hedgeBegin[hedge];
+      Index *end = hedgePins.data() + hedgeBegin[hedge+1];
+      sort(begin, end);
+      if (adjacent_find(begin, end) != end) duplicates[c] = 1;
+    }
+  });
+  if (find(duplicates.begin(), duplicates.end(), 1) != duplicates.end()) {
+    Offset pos = 0;
+    Offset begin = 0;
+    for (Index hedge = 0; hedge < nHedges; ++hedge) {
+      Offset end = hedgeBegin[hedge+1];
+      hedgeBegin[hedge] = pos;
+      for (Offset i = begin; i < end; ++i) {
+        if (i == begin || hedgePins[i] != hedgePins[i-1]) hedgePins[pos++] = hedgePins[i];
+      }
+      begin = end;
+    }
+    hedgeBegin[nHedges] = pos;
+    hedgePins.resize(pos);
+  }
+
+  Hypergraph ret(nNodeWeights, nHedgeWeights, nNodeWeights);
+  ret.nNodes_ = nNodes;
+  ret.nHedges_ = nHedges;
+  ret.hedgeBegin_ = move(hedgeBegin);
+  ret.hedgePins_ = move(hedgePins);
+  ret.nodeWeights_ = move(nodeWeights);
+  ret.hedgeWeights_ = move(hedgeWeights);
+  ret.finalize();
+  return ret;
+}
+
 Hypergraph Hypergraph::coarsen(const Solution &coarsening) const {
+  MINIPART_PROFILE_SCOPE("coarsen");
   assert (nNodes() == coarsening.nNodes());
   assert (coarsening.nParts() <= nNodes());
   assert (coarsening.nParts() > 0);
@@ -35,39 +104,67 @@ Hypergraph Hypergraph::coarsen(const Solution &coarsening) const {
 
   Hypergraph ret(nNodeWeights_, nHedgeWeights_, nPartWeights_);
   ret.nNodes_ = coarsening.nParts();
-  ret.nHedges_ = 0;
   ret.nParts_ = nParts_;
 
-  // Hyperedges
-  vector<Index> pins;
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    for (Index node : hedgeNodes(hedge)) {
-      pins.push_back(coarsening[node]);
-    }
-    sort(pins.begin(), pins.end());
-    pins.resize(unique(pins.begin(), pins.end()) - pins.begin());
-    if (pins.size() > 1) {
-      for (Index i = 0; i < nHedgeWeights_; ++i) {
-        ret.hedgeData_.push_back(hedgeWeight(hedge, i));
+  // Hyperedges: each chunk remaps its hedges to a local fragment
+  Index nHedgeChunks = nChunks(nHedges_);
+  vector<vector<Offset> > fragmentBegins(nHedgeChunks);
+  vector<vector<Index> > fragmentData(nHedgeChunks);
+  vector<vector<Index> > fragmentWeights(nHedgeChunks);
+  parallelChunks(nHedges_, nHedgeChunks, [&](Index c, Index b, Index e) {
+    vector<Index> pins;
+    vector<Offset> &begins = fragmentBegins[c];
+    vector<Index> &data = fragmentData[c];
+    visitPins([&](auto layout) {
+      for (Index hedge = b; hedge < e; ++hedge) {
+        for (Index node : hedgeNodes(hedge, layout)) {
+          pins.push_back(coarsening[node]);
+        }
+        sort(pins.begin(), pins.end());
+        pins.resize(unique(pins.begin(), pins.end()) - pins.begin());
+        if (pins.size() > 1) {
+          for (Index i = 0; i < nHedgeWeights_; ++i) {
+            fragmentWeights[c].push_back(hedgeWeight(hedge, i));
+          }
+          data.insert(data.end(), pins.begin(), pins.end());
+          begins.push_back(data.size());
+        }
+        pins.clear();
       }
-      ret.hedgeData_.insert(ret.hedgeData_.end(), pins.begin(), pins.end());
-      ret.hedgeBegin_.push_back(ret.hedgeData_.size());
-      ++ret.nHedges_;
-    }
-    pins.clear();
+    });
+  });
+  ret.nHedges_ = concatenateFragments(fragmentBegins, fragmentData, ret.hedgeBegin_, ret.hedgePins_);
+  concatenateWeights(fragmentWeights, nHedgeWeights_, ret.hedgeWeights_);
+
+  // Node weights: the nodes of each cluster are listed with a counting sort,
+  // then each chunk of coarse nodes sums the weights of its own clusters
+  Index nCoarseNodes = coarsening.nParts();
+  vector<Index> clusterBegin(nCoarseNodes + 1, 0);
+  for (Index node = 0; node < nNodes_; ++node) {
+    ++clusterBegin[coarsening[node] + 1];
   }
-
-  // Node weights
-  ret.nodeData_.assign(coarsening.nParts() * nNodeWeights_, 0);
+  for (Index c = 0; c < nCoarseNodes; ++c) {
+    clusterBegin[c+1] += clusterBegin[c];
+  }
+  vector<Index> clusterNodes(nNodes_);
   for (Index node = 0; node < nNodes_; ++node) {
-    Index coarsened = coarsening[node];
-    for (Index i = 0; i < nNodeWeights_; ++i) {
-      ret.nodeData_[coarsened * nNodeWeights_ + i] += nodeWeight(node, i);
-    }
+    clusterNodes[clusterBegin[coarsening[node]]++] = node;
   }
-  for (Index i = 1; i <= coarsening.nParts(); ++i) {
-    ret.nodeBegin_.push_back(i * nNodeWeights_);
+  for (Index c = nCoarseNodes; c > 0; --c) {
+    clusterBegin[c] = clusterBegin[c-1];
   }
+  clusterBegin[0] = 0;
+  ret.nodeWeights_.assign((size_t) nCoarseNodes * nNodeWeights_, 0);
+  parallelChunks(nCoarseNodes, nChunks(nCoarseNodes), [&](Index, Index b, Index e) {
+    for (Index i = 0; i < nNodeWeights_; ++i) {
+      Index *coarseWeights = ret.nodeWeights_.data() + (size_t) i * nCoarseNodes;
+      for (Index c = b; c < e; ++c) {
+        for (Index k = clusterBegin[c]; k < clusterBegin[c+1]; ++k) {
+          coarseWeights[c] += nodeWeight(clusterNodes[k], i);
+        }
+      }
+    }
+  });
 
   // Partitions
   ret.partData_ = partData_;
@@ -81,7 +178,298 @@ Hypergraph Hypergraph::coarsen(const Solution &coarsening) const {
   return ret;
 }
 
-void Hypergraph::checkConsistency() const {
+Hypergraph Hypergraph::subHypergraph(const Solution &solution, Index part) const {
+  MINIPART_PROFILE_SCOPE("sub_hypergraph");
+  assert (nNodes() == solution.nNodes());
+
+  // Nodes of the part, in the same order
+  vector<Index> newIndex(nNodes_, -1);
+  Index nSubNodes = 0;
+  for (Index node = 0; node < nNodes_; ++node) {
+    if (solution[node] == part) newIndex[node] = nSubNodes++;
+  }
+
+  Hypergraph ret(nNodeWeights_, nHedgeWeights_, nPartWeights_);
+  ret.nNodes_ = nSubNodes;
+  ret.nHedges_ = 0;
+  ret.nParts_ = 0;
+
+  // Hyperedges restricted to the part
+  vector<Index> pins;
+  vector<Index> subHedges;
+  visitPins([&](auto layout) {
+    for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+      for (Index node : hedgeNodes(hedge, layout)) {
+        if (newIndex[node] != -1) pins.push_back(newIndex[node]);
+      }
+      if (pins.size() > 1) {
+        ret.hedgePins_.insert(ret.hedgePins_.end(), pins.begin(), pins.end());
+        ret.hedgeBegin_.push_back(ret.hedgePins_.size());
+        subHedges.push_back(hedge);
+        ++ret.nHedges_;
+      }
+      pins.clear();
+    }
+  });
+  for (Index i = 0; i < nHedgeWeights_; ++i) {
+    for (Index hedge : subHedges) {
+      ret.hedgeWeights_.push_back(hedgeWeight(hedge, i));
+    }
+  }
+
+  // Node weights
+  for (Index i = 0; i < nNodeWeights_; ++i) {
+    for (Index node = 0; node < nNodes_; ++node) {
+      if (newIndex[node] != -1) ret.nodeWeights_.push_back(nodeWeight(node, i));
+    }
+  }
+
+  // Finalize
+  ret.mergeParallelHedges();
+
+  return ret;
+}
+
+Solution Hypergraph::computeHeavyEdgeClustering(mt19937 &rgen, Index maxClusterWeight, size_t hedgeDegreeCutoff) const {
+  return computeHeavyEdgeClustering(rgen, maxClusterWeight, Solution(nNodes_, 1), hedgeDegreeCutoff);
+}
+
+Solution Hypergraph::computeHeavyEdgeClustering(mt19937 &rgen, Index maxClusterWeight, const Solution &classes, size_t hedgeDegreeCutoff) const {
+  MINIPART_PROFILE_SCOPE("heavy_edge_clustering");
+  assert (classes.nNodes() == nNodes_);
+  vector<Index> order(nNodes_);
+  for (Index node = 0; node < nNodes_; ++node) {
+    order[node] = node;
+  }
+  shuffle(order.begin(), order.end(), rgen);
+
+  vector<Index> clusters(nNodes_, -1);
+  vector<Index> clusterWeights;
+  vector<double> ratings(nNodes_, 0.0);
+  vector<Index> neighbours;
+  visitPins([&](auto layout) {
+    for (Index node : order) {
+      if (clusters[node] != -1) continue;
+
+      // Rate the neighbours: each hedge contributes its weight divided by its number of other pins
+      for (Index hedge : nodeHedges(node, layout)) {
+        auto pins = hedgeNodes(hedge, layout);
+        if (pins.size() > hedgeDegreeCutoff) continue;
+        double rating = hedgeWeight(hedge) / (double) (pins.size() - 1);
+        for (Index neighbour : pins) {
+          if (neighbour == node || classes[neighbour] != classes[node]) continue;
+          if (ratings[neighbour] == 0.0) neighbours.push_back(neighbour);
+          ratings[neighbour] += rating;
+        }
+      }
+
+      // Join the cluster of the best neighbour that respects the weight limit
+      Index best = -1;
+      double bestRating = 0.0;
+      for (Index neighbour : neighbours) {
+        Index cluster = clusters[neighbour];
+        Index weight = nodeWeight(node) + (cluster == -1 ? nodeWeight(neighbour) : clusterWeights[cluster]);
+        if (weight <= maxClusterWeight && ratings[neighbour] > bestRating) {
+          best = neighbour;
+          bestRating = ratings[neighbour];
+        }
+        ratings[neighbour] = 0.0;
+      }
+      neighbours.clear();
+
+      if (best == -1) {
+        clusters[node] = clusterWeights.size();
+        clusterWeights.push_back(nodeWeight(node));
+      }
+      else {
+        if (clusters[best] == -1) {
+          clusters[best] = clusterWeights.size();
+          clusterWeights.push_back(nodeWeight(best));
+        }
+        clusters[node] = clusters[best];
+        clusterWeights[clusters[node]] += nodeWeight(node);
+      }
+    }
+  });
+
+  return Solution(clusters);
+}
+
+Solution Hypergraph::computeLocalityOrdering(size_t hedgeDegreeCutoff) const {
+  MINIPART_PROFILE_SCOPE("locality_ordering");
+  // Reverse Cuthill-McKee: breadth-first search through the hedges, visiting low-degree nodes first
+  vector<Index> degrees(nNodes_);
+  vector<Index> starts(nNodes_);
+  visitPins([&](auto layout) {
+    for (Index node = 0; node < nNodes_; ++node) {
+      degrees[node] = nodeHedges(node, layout).size();
+      starts[node] = node;
+    }
+  });
+  auto lowerDegree = [&](Index n1, Index n2) {
+    return degrees[n1] < degrees[n2] || (degrees[n1] == degrees[n2] && n1 < n2);
+  };
+  sort(starts.begin(), starts.end(), lowerDegree);
+
+  vector<Index> order;
+  order.reserve(nNodes_);
+  vector<char> visitedNodes(nNodes_, 0);
+  vector<char> visitedHedges(nHedges_, 0);
+  vector<Index> neighbours;
+  visitPins([&](auto layout) {
+    for (Index start : starts) {
+      if (visitedNodes[start]) continue;
+      visitedNodes[start] = 1;
+      size_t head = order.size();
+      order.push_back(start);
+      for (; head < order.size(); ++head) {
+        for (Index hedge : nodeHedges(order[head], layout)) {
+          if (visitedHedges[hedge]) continue;
+          visitedHedges[hedge] = 1;
+          // Large hedges do not bring their pins together
+          auto pins = hedgeNodes(hedge, layout);
+          if (pins.size() > hedgeDegreeCutoff) continue;
+          for (Index neighbour : pins) {
+            if (visitedNodes[neighbour]) continue;
+            visitedNodes[neighbour] = 1;
+            neighbours.push_back(neighbour);
+          }
+          sort(neighbours.begin(), neighbours.end(), lowerDegree);
+          order.insert(order.end(), neighbours.begin(), neighbours.end());
+          neighbours.clear();
+        }
+      }
+    }
+  });
+
+  Solution ordering(nNodes_, nNodes_);
+  for (Index i = 0; i < nNodes_; ++i) {
+    ordering[order[i]] = nNodes_ - 1 - i;
+  }
+  return ordering;
+}
+
+Hypergraph Hypergraph::reorder(const Solution &ordering) const {
+  MINIPART_PROFILE_SCOPE("reorder");
+  assert (ordering.nNodes() == nNodes());
+  assert (ordering.nParts() == nNodes());
+
+  Hypergraph ret(nNodeWeights_, nHedgeWeights_, nPartWeights_);
+  ret.nNodes_ = nNodes_;
+  ret.nHedges_ = nHedges_;
+  ret.nParts_ = nParts_;
+
+  // Hedges are sorted by their first node in the new order, with a counting sort
+  vector<Index> hedgeKeys(nHedges_);
+  parallelChunks(nHedges_, nChunks(nHedges_), [&](Index, Index b, Index e) {
+    visitPins([&](auto layout) {
+      for (Index hedge = b; hedge < e; ++hedge) {
+        Index key = nNodes_;
+        for (Index node : hedgeNodes(hedge, layout)) {
+          key = min(key, ordering[node]);
+        }
+        hedgeKeys[hedge] = key;
+      }
+    });
+  });
+  vector<Index> keyBegin(nNodes_ + 2, 0);
+  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+    ++keyBegin[hedgeKeys[hedge] + 1];
+  }
+  for (Index key = 0; key <= nNodes_; ++key) {
+    keyBegin[key + 1] += keyBegin[key];
+  }
+  vector<Index> hedgeOrder(nHedges_);
+  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+    hedgeOrder[keyBegin[hedgeKeys[hedge]]++] = hedge;
+  }
+
+  // Pins, renumbered and sorted again
+  ret.hedgeBegin_.assign(nHedges_ + 1, 0);
+  visitPins([&](auto layout) {
+    for (Index i = 0; i < nHedges_; ++i) {
+      ret.hedgeBegin_[i+1] = ret.hedgeBegin_[i] + hedgeNodes(hedgeOrder[i], layout).size();
+    }
+  });
+  ret.hedgePins_.resize(ret.hedgeBegin_.back());
+  parallelChunks(nHedges_, nChunks(nHedges_), [&](Index, Index b, Index e) {
+    visitPins([&](auto layout) {
+      for (Index i = b; i < e; ++i) {
+        Index *begin = ret.hedgePins_.data() + ret.hedgeBegin_[i];
+        Index *end = begin;
+        for (Index node : hedgeNodes(hedgeOrder[i], layout)) {
+          *end++ = ordering[node];
+        }
+        sort(begin, end);
+      }
+    });
+  });
+
+  // Weights
+  ret.hedgeWeights_.resize(hedgeWeights_.size());
+  ret.nodeWeights_.resize(nodeWeights_.size());
+  for (Index j = 0; j < nHedgeWeights_; ++j) {
+    for (Index i = 0; i < nHedges_; ++i) {
+      ret.hedgeWeights_[(size_t) j * nHedges_ + i] = hedgeWeight(hedgeOrder[i], j);
+    }
+  }
+  for (Index j = 0; j < nNodeWeights_; ++j) {
+    for (Index node = 0; node < nNodes_; ++node) {
+      ret.nodeWeights_[(size_t) j * nNodes_ + ordering[node]] = nodeWeight(node, j);
+    }
+  }
+  ret.partData_ = partData_;
+
+  ret.finalize();
+  return ret;
+}
+
+Index Hypergraph::concatenateFragments(const vector<vector<Offset> > &fragmentBegins, const vector<vector<Index> > &fragmentData, vector<Offset> &begins, vector<Index> &data) {
+  Index nFragments = fragmentBegins.size();
+  vector<Index> beginOffsets(nFragments + 1, 0);
+  vector<Offset> dataOffsets(nFragments + 1, 0);
+  for (Index c = 0; c < nFragments; ++c) {
+    beginOffsets[c+1] = beginOffsets[c] + fragmentBegins[c].size();
+    dataOffsets[c+1] = dataOffsets[c] + fragmentData[c].size();
+  }
+  begins.resize(beginOffsets.back() + 1);
+  data.resize(dataOffsets.back());
+  begins[0] = 0;
+  parallelChunks(nFragments, nFragments, [&](Index c, Index, Index) {
+    Offset offset = dataOffsets[c];
+    Offset *beginOut = begins.data() + beginOffsets[c] + 1;
+    for (Offset b : fragmentBegins[c]) {
+      *beginOut++ = b + offset;
+    }
+    copy(fragmentData[c].begin(), fragmentData[c].end(), data.begin() + offset);
+  });
+  return beginOffsets.back();
+}
+
+void Hypergraph::concatenateWeights(const vector<vector<Index> > &fragmentWeights, Index nWeights, vector<Index> &weights) {
+  // The fragments hold all the weights of each element together, the result all the elements for each weight
+  Index nFragments = fragmentWeights.size();
+  vector<Index> offsets(nFragments + 1, 0);
+  for (Index c = 0; c < nFragments; ++c) {
+    offsets[c+1] = offsets[c] + (nWeights == 0 ? 0 : fragmentWeights[c].size() / nWeights);
+  }
+  Index nElements = offsets.back();
+  weights.resize((size_t) nElements * nWeights);
+  parallelChunks(nFragments, nFragments, [&](Index c, Index, Index) {
+    const vector<Index> &fragment = fragmentWeights[c];
+    Index nFragmentElements = offsets[c+1] - offsets[c];
+    for (Index i = 0; i < nWeights; ++i) {
+      Index *out = weights.data() + (size_t) i * nElements + offsets[c];
+      for (Index j = 0; j < nFragmentElements; ++j) {
+        out[j] = fragment[(size_t) j * nWeights + i];
+      }
+    }
+  });
+}
+
+void Hypergraph::checkConsistency(ValidationLevel level) const {
+  if (level == ValidationLevel::Off) return;
+
   if (nNodes_ < 0) throw runtime_error("Negative number of nodes");
   if (nHedges_ < 0) throw runtime_error("Negative number of hedges");
   if (nParts_ < 0) throw runtime_error("Negative number of parts");
@@ -90,49 +478,78 @@ void Hypergraph::checkConsistency() const {
   if (nHedgeWeights_ < 0) throw runtime_error("Negative number of hedge weights");
   if (nPartWeights_ < 0) throw runtime_error("Negative number of part weights");
 
-  if ((Index) nodeBegin_.size() != nNodes_ + 1)
-    throw runtime_error("Number of node limits and of nodes do not match");
-  if ((Index) hedgeBegin_.size() != nHedges_ + 1)
-    throw runtime_error("Number of hedge limits and of hedges do not match");
-
-  for (size_t i = 0; i + 1 < nodeBegin_.size(); ++i) {
-    if (nodeBegin_[i] + nNodeWeights_ > nodeBegin_[i+1])
-        throw runtime_error("Inconsistent node data");
+  if (pinsCompressed_) {
+    // The encoded pins are only checked once decoded
+    Offset nodePins = 0;
+    Offset hedgePins = 0;
+    for (Index n = 0; n != nNodes_; ++n) nodePins += nodeHedges(n, CompressedPins()).size();
+    for (Index h = 0; h != nHedges_; ++h) hedgePins += hedgeNodes(h, CompressedPins()).size();
+    if (nPins_ != nodePins) throw runtime_error("Inconsistent node data size");
+    if (nPins_ != hedgePins) throw runtime_error("Inconsistent hedge data size");
   }
-  if (nodeBegin_.front() != 0) throw runtime_error("Inconsistent node data begin");
-  if (nodeBegin_.back() != (Index) nodeData_.size()) throw runtime_error("Inconsistent node data end");
+  else {
+    if ((Index) nodeBegin_.size() != nNodes_ + 1)
+      throw runtime_error("Number of node limits and of nodes do not match");
+    if ((Index) hedgeBegin_.size() != nHedges_ + 1)
+      throw runtime_error("Number of hedge limits and of hedges do not match");
+
+    for (size_t i = 0; i + 1 < nodeBegin_.size(); ++i) {
+      if (nodeBegin_[i] > nodeBegin_[i+1])
+          throw runtime_error("Inconsistent node data");
+    }
+    if (nodeBegin_.front() != 0) throw runtime_error("Inconsistent node data begin");
+    if (nodeBegin_.back() != (Offset) nodePins_.size()) throw runtime_error("Inconsistent node data end");
 
-  for (size_t i = 0; i + 1 < hedgeBegin_.size(); ++i) {
-    if (hedgeBegin_[i] + nHedgeWeights_ > hedgeBegin_[i+1])
-        throw runtime_error("Inconsistent hedge data");
-  }
-  if (hedgeBegin_.front() != 0) throw runtime_error("Inconsistent hedge data begin");
-  if (hedgeBegin_.back() != (Index) hedgeData_.size()) throw runtime_error("Inconsistent hedge data end");
+    for (size_t i = 0; i + 1 < hedgeBegin_.size(); ++i) {
+      if (hedgeBegin_[i] > hedgeBegin_[i+1])
+          throw runtime_error("Inconsistent hedge data");
+    }
+    if (hedgeBegin_.front() != 0) throw runtime_error("Inconsistent hedge data begin");
+    if (hedgeBegin_.back() != (Offset) hedgePins_.size()) throw runtime_error("Inconsistent hedge data end");
 
-  if (nPins_ + nNodeWeights_ * nNodes_ != (Index) nodeData_.size()) throw runtime_error("Inconsistent node data size");
-  if (nPins_ + nHedgeWeights_ * nHedges_ != (Index) hedgeData_.size()) throw runtime_error("Inconsistent hedge data size");
+    if (nPins_ != (Offset) nodePins_.size()) throw runtime_error("Inconsistent node data size");
+    if (nPins_ != (Offset) hedgePins_.size()) throw runtime_error("Inconsistent hedge data size");
+  }
+  if ((Offset) nNodeWeights_ * nNodes_ != (Offset) nodeWeights_.size()) throw runtime_error("Inconsistent node weights size");
+  if ((Offset) nHedgeWeights_ * nHedges_ != (Offset) hedgeWeights_.size()) throw runtime_error("Inconsistent hedge weights size");
   if (nPartWeights_ * nParts_ != (Index) partData_.size()) throw runtime_error("Inconsistent part data size");
 
-  for (Index n = 0; n != nNodes_; ++n) {
-    Range<Index> node = nodeHedges(n);
-    for (Index hedge : node) {
-      if (hedge < 0 || hedge >= nHedges())
-        throw runtime_error("Invalid hedge value");
+  visitPins([&](auto layout) {
+    for (Index n = 0; n != nNodes_; ++n) {
+      for (Index hedge : nodeHedges(n, layout)) {
+        if (hedge < 0 || hedge >= nHedges())
+          throw runtime_error("Invalid hedge value");
+      }
     }
-    unordered_set<Index> uq(node.begin(), node.end());
-    if (uq.size() != node.size())
-        throw runtime_error("Duplicate hedges in a node");
-  }
-  for (Index h = 0; h != nHedges_; ++h) {
-    Range<Index> hedge = hedgeNodes(h);
-    for (Index node : hedge) {
-      if (node < 0 || node >= nNodes())
-        throw runtime_error("Invalid node value");
+    for (Index h = 0; h != nHedges_; ++h) {
+      for (Index node : hedgeNodes(h, layout)) {
+        if (node < 0 || node >= nNodes())
+          throw runtime_error("Invalid node value");
+      }
     }
-    unordered_set<Index> uq(hedge.begin(), hedge.end());
-    if (uq.size() != hedge.size())
-        throw runtime_error("Duplicate nodes in an hedge");
-  }
+  });
+
+  if (level != ValidationLevel::Full) return;
+
+  // Duplicate detection: each element is stamped with the last node/hedge it was seen in
+  visitPins([&](auto layout) {
+    vector<Index> hedgeStamps(nHedges_, -1);
+    for (Index n = 0; n != nNodes_; ++n) {
+      for (Index hedge : nodeHedges(n, layout)) {
+        if (hedgeStamps[hedge] == n)
+          throw runtime_error("Duplicate hedges in a node");
+        hedgeStamps[hedge] = n;
+      }
+    }
+    vector<Index> nodeStamps(nNodes_, -1);
+    for (Index h = 0; h != nHedges_; ++h) {
+      for (Index node : hedgeNodes(h, layout)) {
+        if (nodeStamps[node] == h)
+          throw runtime_error("Duplicate nodes in an hedge");
+        nodeStamps[node] = h;
+      }
+    }
+  });
 
   // TODO: check that there is a bidirectional mapping between nodes and hedges
 }
@@ -143,17 +560,16 @@ void Hypergraph::finalize() {
   finalizeNodeWeights();
   finalizeHedgeWeights();
   finalizePartWeights();
-  checkConsistency();
 }
 
 void Hypergraph::finalizePins() {
-  nPins_ = hedgeData_.size() - nHedges_ * nHedgeWeights_;
+  nPins_ = hedgePins_.size();
 }
 
 void Hypergraph::finalizeNodeWeights() {
   totalNodeWeights_.assign(nNodeWeights_, 0);
-  for (Index i = 0; i < nNodes_; ++i) {
-    for (Index j = 0; j < nNodeWeights_; ++j) {
+  for (Index j = 0; j < nNodeWeights_; ++j) {
+    for (Index i = 0; i < nNodes_; ++i) {
       totalNodeWeights_[j] += nodeWeight(i, j);
     }
   }
@@ -161,8 +577,8 @@ void Hypergraph::finalizeNodeWeights() {
 
 void Hypergraph::finalizeHedgeWeights() {
   totalHedgeWeights_.assign(nHedgeWeights_, 0);
-  for (Index i = 0; i < nHedges_; ++i) {
-    for (Index j = 0; j < nHedgeWeights_; ++j) {
+  for (Index j = 0; j < nHedgeWeights_; ++j) {
+    for (Index i = 0; i < nHedges_; ++i) {
       totalHedgeWeights_[j] += hedgeWeight(i, j);
     }
   }
@@ -178,109 +594,277 @@ void Hypergraph::finalizePartWeights() {
 }
 
 void Hypergraph::finalizeNodes() {
-  vector<Index> newData;
-  vector<Index> newBegin;
-  newBegin.assign(nNodes_ + 1, 0);
-
-  // Setup node begins
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    for (Index node : hedgeNodes(hedge)) {
-      ++newBegin[node+1];
+  MINIPART_PROFILE_SCOPE("finalize_nodes");
+  assert (!pinsCompressed_);
+  // Count the pins of each node; memory stays proportional to the nodes whatever the number of threads
+  Index nHedgeChunks = nChunks(nHedges_);
+  Index nNodeChunks = nChunks(nNodes_);
+  vector<atomic<Offset> > cursors(nNodes_);
+  parallelChunks(nNodes_, nNodeChunks, [&](Index, Index b, Index e) {
+    for (Index node = b; node < e; ++node) {
+      cursors[node].store(0, memory_order_relaxed);
     }
-  }
-  for (Index node = 1; node <= nNodes_; ++node) {
-    newBegin[node] += newBegin[node-1] + nNodeWeights_;
-  }
-  newData.resize(newBegin.back());
-  assert ((Index) newData.size() == nPins_ + nNodes_ * nNodeWeights_);
-
-  // Assign node weights
-  for (Index node = 0; node < nNodes_; ++node) {
-    Index b = newBegin[node];
-    for (Index i = 0; i < nNodeWeights_; ++i) {
-      newData[b + i] = nodeWeight(node, i);
+  });
+  parallelChunks(nHedges_, nHedgeChunks, [&](Index, Index b, Index e) {
+    for (Index hedge = b; hedge < e; ++hedge) {
+      for (Index node : hedgeNodes(hedge)) {
+        cursors[node].fetch_add(1, memory_order_relaxed);
+      }
+    }
+  });
+
+  // Setup node begins: prefix sum within each chunk of nodes, then offset by the previous chunks
+  vector<Offset> newBegin(nNodes_ + 1, 0);
+  vector<Offset> chunkOffsets(nNodeChunks + 1, 0);
+  parallelChunks(nNodes_, nNodeChunks, [&](Index c, Index b, Index e) {
+    Offset size = 0;
+    for (Index node = b; node < e; ++node) {
+      size += cursors[node].load(memory_order_relaxed);
+      newBegin[node+1] = size;
     }
+    chunkOffsets[c+1] = size;
+  });
+  for (Index c = 0; c < nNodeChunks; ++c) {
+    chunkOffsets[c+1] += chunkOffsets[c];
   }
-  nodeBegin_ = newBegin;
+  parallelChunks(nNodes_, nNodeChunks, [&](Index c, Index b, Index e) {
+    for (Index node = b; node < e; ++node) {
+      newBegin[node+1] += chunkOffsets[c];
+      // Pins are inserted from the end, so that hedges are in decreasing order for each node
+      cursors[node].store(newBegin[node+1], memory_order_relaxed);
+    }
+  });
+  vector<Index> newData(newBegin.back());
+  assert ((Offset) newData.size() == nPins_);
 
   // Assign pins
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    for (Index node : hedgeNodes(hedge)) {
-      Index ind = --newBegin[node+1];
-      newData[ind] = hedge;
+  parallelChunks(nHedges_, nHedgeChunks, [&](Index, Index b, Index e) {
+    for (Index hedge = b; hedge < e; ++hedge) {
+      for (Index node : hedgeNodes(hedge)) {
+        newData[cursors[node].fetch_sub(1, memory_order_relaxed) - 1] = hedge;
+      }
     }
+  });
+  // With several chunks, the insertion order depends on the scheduling
+  if (nHedgeChunks > 1) {
+    parallelChunks(nNodes_, nNodeChunks, [&](Index, Index b, Index e) {
+      for (Index node = b; node < e; ++node) {
+        sort(newData.begin() + newBegin[node], newData.begin() + newBegin[node+1], greater<Index>());
+      }
+    });
   }
 
-  nodeData_ = newData;
+  nodeBegin_.swap(newBegin);
+  nodePins_.swap(newData);
 }
 
 namespace {
-class HedgeHasher {
- public:
-  HedgeHasher(const Hypergraph &hypergraph)
-    : hypergraph_(hypergraph) {}
+uint64_t hedgeFingerprint(const PinRange &pins) {
+  // FNV hash
+  uint64_t magic = 1099511628211llu;
+  uint64_t ret = 0;
+  for (Index n : pins) {
+    ret = (ret ^ (uint64_t) n) * magic;
+  }
+  return ret;
+}
+} // End anonymous namespace
 
-  size_t operator()(const Index &hedge) const {
-    // FNV hash
-    uint64_t magic = 1099511628211llu;
-    uint64_t ret = 0;
-    for (Index n : hypergraph_.hedgeNodes(hedge)) {
-      ret = (ret ^ (uint64_t) n) * magic;
+void Hypergraph::mergeParallelHedges() {
+  MINIPART_PROFILE_SCOPE("merge_parallel_hedges");
+  // The pins are rebuilt in plain form
+  if (pinsCompressed_) decompressPins();
+  // Sort the hedges by fingerprint, then by pins, so that identical hedges are contiguous
+  vector<uint64_t> fingerprints(nHedges_);
+  parallelChunks(nHedges_, nChunks(nHedges_), [&](Index, Index b, Index e) {
+    for (Index hedge = b; hedge < e; ++hedge) {
+      fingerprints[hedge] = hedgeFingerprint(hedgeNodes(hedge));
     }
-    return ret;
+  });
+  auto samePins = [&](Index h1, Index h2) {
+    return fingerprints[h1] == fingerprints[h2] && hedgeNodes(h1) == hedgeNodes(h2);
+  };
+  vector<Index> order(nHedges_);
+  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+    order[hedge] = hedge;
   }
+  parallelSort(order.begin(), order.end(), [&](Index h1, Index h2) {
+    if (fingerprints[h1] != fingerprints[h2])
+      return fingerprints[h1] < fingerprints[h2];
+    PinRange p1 = hedgeNodes(h1);
+    PinRange p2 = hedgeNodes(h2);
+    if (p1 != p2)
+      return lexicographical_compare(p1.begin(), p1.end(), p2.begin(), p2.end());
+    return h1 < h2;
+  });
+
+  // The first hedge of each group is kept, with the weights of the whole group
+  vector<Index> mergedWeights((size_t) nHedges_ * nHedgeWeights_);
+  vector<char> kept(nHedges_, 0);
+  parallelChunks(nHedges_, nChunks(nHedges_), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      Index hedge = order[i];
+      if (i > 0 && samePins(order[i-1], hedge)) continue;
+      kept[hedge] = 1;
+      for (Index j = 0; j < nHedgeWeights_; ++j) {
+        mergedWeights[(size_t) hedge * nHedgeWeights_ + j] = hedgeWeight(hedge, j);
+      }
+      for (Index k = i + 1; k < nHedges_ && samePins(hedge, order[k]); ++k) {
+        for (Index j = 0; j < nHedgeWeights_; ++j) {
+          mergedWeights[(size_t) hedge * nHedgeWeights_ + j] += hedgeWeight(order[k], j);
+        }
+      }
+    }
+  });
+
+  // Gather the remaining hedges in their original order
+  Index nHedgeChunks = nChunks(nHedges_);
+  vector<vector<Offset> > fragmentBegins(nHedgeChunks);
+  vector<vector<Index> > fragmentData(nHedgeChunks);
+  vector<vector<Index> > fragmentWeights(nHedgeChunks);
+  parallelChunks(nHedges_, nHedgeChunks, [&](Index c, Index b, Index e) {
+    vector<Offset> &begins = fragmentBegins[c];
+    vector<Index> &data = fragmentData[c];
+    for (Index hedge = b; hedge < e; ++hedge) {
+      if (!kept[hedge]) continue;
+      for (Index j = 0; j < nHedgeWeights_; ++j) {
+        fragmentWeights[c].push_back(mergedWeights[(size_t) hedge * nHedgeWeights_ + j]);
+      }
+      for (Index node : hedgeNodes(hedge)) {
+        data.push_back(node);
+      }
+      begins.push_back(data.size());
+    }
+  });
 
- private:
-  const Hypergraph &hypergraph_;
-};
+  vector<Offset> newHedgeBegin;
+  vector<Index> newHedgePins;
+  vector<Index> newHedgeWeights;
+  nHedges_ = concatenateFragments(fragmentBegins, fragmentData, newHedgeBegin, newHedgePins);
+  concatenateWeights(fragmentWeights, nHedgeWeights_, newHedgeWeights);
+  hedgeBegin_.swap(newHedgeBegin);
+  hedgePins_.swap(newHedgePins);
+  hedgeWeights_.swap(newHedgeWeights);
 
-class HedgeComparer {
- public:
-  HedgeComparer(const Hypergraph &hypergraph)
-    : hypergraph_(hypergraph) {}
+  finalize();
+}
 
-  bool operator()(const Index &h1, const Index &h2) const {
-    return hypergraph_.hedgeNodes(h1) == hypergraph_.hedgeNodes(h2);
-  }
+namespace {
+uint32_t zigzag(Index delta) {
+  return ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+}
 
- private:
-  const Hypergraph &hypergraph_;
-};
-} // End anonymous namespace
+Offset varintSize(uint32_t v) {
+  Offset ret = 1;
+  for (; v >= 0x80; v >>= 7) ++ret;
+  return ret;
+}
 
-void Hypergraph::mergeParallelHedges() {
-  vector<Index> newHedgeBegin;
-  vector<Index> newHedgeData;
-  newHedgeBegin.push_back(0);
+uint8_t *writeVarint(uint8_t *out, uint32_t v) {
+  for (; v >= 0x80; v >>= 7) {
+    *out++ = (uint8_t) (v | 0x80);
+  }
+  *out++ = (uint8_t) v;
+  return out;
+}
 
-  unordered_map<Index, Index, HedgeHasher, HedgeComparer> hedgeWeightMap(nHedges(), HedgeHasher(*this), HedgeComparer(*this));
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    Index ind = newHedgeBegin.size() - 1;
-    auto p = hedgeWeightMap.emplace(hedge, ind);
-    if (p.second) {
-      // No such hyperedge exists yet
-      for (Index i = 0; i < nHedgeWeights_; ++i) {
-        newHedgeData.push_back(hedgeWeight(hedge, i));
-      }
-      for (Index node : hedgeNodes(hedge)) {
-        newHedgeData.push_back(node);
+/**
+ * Encode each list of pins as its size, followed by the differences between consecutive pins
+ */
+void encodePins(Index n, const vector<Offset> &begins, const vector<Index> &pins, vector<Offset> &byteBegins, vector<uint8_t> &bytes) {
+  byteBegins.assign(n + 1, 0);
+  parallelChunks(n, nChunks(n), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      Offset size = varintSize(begins[i+1] - begins[i]);
+      Index prev = 0;
+      for (Offset j = begins[i]; j < begins[i+1]; ++j) {
+        size += varintSize(zigzag(pins[j] - prev));
+        prev = pins[j];
       }
-      newHedgeBegin.push_back(newHedgeData.size());
+      byteBegins[i+1] = size;
     }
-    else {
-      // An equivalent hyperedge exists already
-      Index s = newHedgeBegin[p.first->second];
-      for (Index i = 0; i < nHedgeWeights_; ++i) {
-        newHedgeData[s + i] += hedgeWeight(hedge, i);
+  });
+  for (Index i = 0; i < n; ++i) {
+    byteBegins[i+1] += byteBegins[i];
+  }
+  bytes.resize(byteBegins.back());
+  parallelChunks(n, nChunks(n), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      uint8_t *out = writeVarint(bytes.data() + byteBegins[i], begins[i+1] - begins[i]);
+      Index prev = 0;
+      for (Offset j = begins[i]; j < begins[i+1]; ++j) {
+        out = writeVarint(out, zigzag(pins[j] - prev));
+        prev = pins[j];
       }
     }
+  });
+}
+
+void decodePins(Index n, const PinOffsets &byteBegins, const vector<uint8_t> &bytes, vector<Offset> &begins, vector<Index> &pins) {
+  begins.assign(n + 1, 0);
+  for (Index i = 0; i < n; ++i) {
+    const uint8_t *ptr = bytes.data() + byteBegins[i];
+    begins[i+1] = begins[i] + readVarint(ptr);
   }
+  pins.resize(begins.back());
+  parallelChunks(n, nChunks(n), [&](Index, Index b, Index e) {
+    for (Index i = b; i < e; ++i) {
+      CompressedPinRange range(bytes.data() + byteBegins[i], bytes.data() + byteBegins[i+1]);
+      copy(range.begin(), range.end(), pins.begin() + begins[i]);
+    }
+  });
+}
+} // End anonymous namespace
 
-  nHedges_ = newHedgeBegin.size() - 1;
-  hedgeBegin_ = newHedgeBegin;
-  hedgeData_ = newHedgeData;
+PinOffsets::PinOffsets(const vector<Offset> &offsets) {
+  Index n = offsets.size();
+  bases_.resize(((n - 1) >> blockBits) + 1);
+  offsets_.resize(n);
+  for (Index i = 0; i < n; ++i) {
+    if ((i & ((1 << blockBits) - 1)) == 0) bases_[i >> blockBits] = offsets[i];
+    Offset offset = offsets[i] - bases_[i >> blockBits];
+    if (offset > numeric_limits<uint32_t>::max()) throw runtime_error("Pin lists too large to be compressed");
+    offsets_[i] = offset;
+  }
+}
 
-  finalize();
+int64_t PinOffsets::bytes() const {
+  return bases_.size() * sizeof(Offset) + offsets_.size() * sizeof(uint32_t);
+}
+
+void Hypergraph::compressPins() {
+  MINIPART_PROFILE_SCOPE("compress_pins");
+  if (pinsCompressed_) return;
+  // One side at a time, to limit the peak memory
+  vector<Offset> byteBegins;
+  encodePins(nHedges_, hedgeBegin_, hedgePins_, byteBegins, hedgeBytes_);
+  hedgeByteBegin_ = PinOffsets(byteBegins);
+  vector<Offset>().swap(hedgeBegin_);
+  vector<Index>().swap(hedgePins_);
+  encodePins(nNodes_, nodeBegin_, nodePins_, byteBegins, nodeBytes_);
+  nodeByteBegin_ = PinOffsets(byteBegins);
+  vector<Offset>().swap(nodeBegin_);
+  vector<Index>().swap(nodePins_);
+  pinsCompressed_ = true;
+}
+
+void Hypergraph::decompressPins() {
+  if (!pinsCompressed_) return;
+  decodePins(nHedges_, hedgeByteBegin_, hedgeBytes_, hedgeBegin_, hedgePins_);
+  hedgeByteBegin_ = PinOffsets();
+  vector<uint8_t>().swap(hedgeBytes_);
+  decodePins(nNodes_, nodeByteBegin_, nodeBytes_, nodeBegin_, nodePins_);
+  nodeByteBegin_ = PinOffsets();
+  vector<uint8_t>().swap(nodeBytes_);
+  pinsCompressed_ = false;
+}
+
+int64_t Hypergraph::pinBytes() const {
+  int64_t ret = (nodeBegin_.size() + hedgeBegin_.size()) * sizeof(Offset);
+  ret += (nodePins_.size() + hedgePins_.size()) * sizeof(Index);
+  ret += nodeByteBegin_.bytes() + hedgeByteBegin_.bytes();
+  ret += nodeBytes_.size() + hedgeBytes_.size();
+  return ret;
 }
 
 void Hypergraph::setupBlocks(Index nParts, double imbalanceFactor) {
@@ -291,8 +875,10 @@ void Hypergraph::setupBlocks(Index nParts, double imbalanceFactor) {
   if (nParts > 0) {
     partData_.resize(nPartWeights_ * nParts);
     for (Index i = 0; i < nPartWeights_; ++i) {
-      Index totalCapacity = totalNodeWeight(i) * (1.0 + imbalanceFactor);
-      Index partitionCapacity = totalCapacity  / nParts;
+      int64_t totalCapacity = totalNodeWeight(i) * (1.0 + imbalanceFactor);
+      int64_t partitionCapacity = totalCapacity  / nParts;
+      if (totalCapacity - partitionCapacity * (nParts - 1) > numeric_limits<Index>::max())
+        throw runtime_error("The capacity of the partitions exceeds the range of the weights");
       partData_[i] = totalCapacity - partitionCapacity * (nParts - 1);
       for (Index p = 1; p < nParts; ++p) {
         partData_[p * nPartWeights_ + i] = partitionCapacity;
@@ -305,19 +891,32 @@ void Hypergraph::setupBlocks(Index nParts, double imbalanceFactor) {
   finalizePartWeights();
 }
 
+void Hypergraph::setupBlocks(Index nParts, const vector<Index> &capacities) {
+  // Setup partitions with the given capacities, nPartWeights per partition
+  if ((Index) capacities.size() != nParts * nPartWeights_)
+    throw runtime_error("The number of capacities does not match the number of partitions and weights");
+  nParts_ = nParts;
+  partData_ = capacities;
+  finalizePartWeights();
+}
+
 bool Hypergraph::cut(const Solution &solution, Index hedge) const {
   unordered_set<Index> parts;
-  for (Index node : hedgeNodes(hedge)) {
-    parts.insert(solution[node]);
-  }
+  visitPins([&](auto layout) {
+    for (Index node : hedgeNodes(hedge, layout)) {
+      parts.insert(solution[node]);
+    }
+  });
   return parts.size() > 1;
 }
 
 Index Hypergraph::degree(const Solution &solution, Index hedge) const {
   unordered_set<Index> parts;
-  for (Index node : hedgeNodes(hedge)) {
-    parts.insert(solution[node]);
-  }
+  visitPins([&](auto layout) {
+    for (Index node : hedgeNodes(hedge, layout)) {
+      parts.insert(solution[node]);
+    }
+  });
   return parts.size();
 }
 
@@ -0,0 +1,131 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "hypergraph_cache.hh"
+#include "hypergraph.hh"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <ctime>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace minipart {
+
+namespace {
+uint64_t hashBytes(uint64_t hash, const char *data, size_t size) {
+  // FNV-style hash on 64-bit words
+  uint64_t magic = 1099511628211llu;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * magic;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ (uint64_t) (unsigned char) data[i]) * magic;
+  }
+  return hash;
+}
+
+bool isEntry(const fs::path &path) {
+  // Entries are named <key>.mgb; temporary files being written by other runs have an additional extension
+  return path.extension() == ".mgb" && path.stem().extension().empty();
+}
+} // End anonymous namespace
+
+HypergraphCache::HypergraphCache(const string &directory, int64_t maxBytes)
+: directory_(directory)
+, maxBytes_(maxBytes) {
+  if (maxBytes < 0) throw runtime_error("The cache size must be non-negative");
+  fs::create_directories(directory_);
+}
+
+string HypergraphCache::key(const string &inputFile, const string &options) const {
+  ifstream f(inputFile, ios_base::in | ios_base::binary);
+  if (f.fail()) throw runtime_error("Unable to open the file \"" + inputFile + "\"");
+  // The format is given by the extensions of the file
+  string filename = fs::path(inputFile).filename().string();
+  string format = filename.substr(min(filename.find('.'), filename.size()));
+  uint64_t hash = hashBytes(0, options.data(), options.size());
+  hash = hashBytes(hash, format.data(), format.size());
+  char buffer[1 << 16];
+  while (f) {
+    f.read(buffer, sizeof(buffer));
+    hash = hashBytes(hash, buffer, f.gcount());
+  }
+  char ret[17];
+  snprintf(ret, sizeof(ret), "%016llx", (unsigned long long) hash);
+  return ret;
+}
+
+string HypergraphCache::entryPath(const string &key) const {
+  return (fs::path(directory_) / (key + ".mgb")).string();
+}
+
+bool HypergraphCache::read(const string &key, Hypergraph &hypergraph) const {
+  string path = entryPath(key);
+  boost::system::error_code ec;
+  if (!fs::exists(path, ec)) return false;
+  try {
+    hypergraph = Hypergraph::readFile(path);
+  } catch (exception &) {
+    fs::remove(path, ec);
+    return false;
+  }
+  // Mark the entry as recently used
+  fs::last_write_time(path, time(nullptr), ec);
+  return true;
+}
+
+void HypergraphCache::write(const string &key, const Hypergraph &hypergraph) const {
+  // Write to a temporary file first, so that concurrent runs never read a partial entry
+  string tmpPath = entryPath(key + "." + to_string(getpid()) + ".tmp");
+  try {
+    hypergraph.writeFile(tmpPath);
+    fs::rename(tmpPath, entryPath(key));
+    evict();
+  } catch (exception &e) {
+    boost::system::error_code ec;
+    fs::remove(tmpPath, ec);
+    cerr << "Unable to write to the cache: " << e.what() << endl;
+  }
+}
+
+void HypergraphCache::evict() const {
+  struct Entry {
+    time_t lastUse;
+    int64_t size;
+    fs::path path;
+  };
+  vector<Entry> entries;
+  int64_t totalSize = 0;
+  boost::system::error_code ec;
+  for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+    fs::path path = it->path();
+    if (!isEntry(path) || !fs::is_regular_file(path, ec)) continue;
+    Entry entry;
+    entry.size = fs::file_size(path, ec);
+    if (ec) continue;
+    entry.lastUse = fs::last_write_time(path, ec);
+    if (ec) continue;
+    entry.path = path;
+    entries.push_back(entry);
+    totalSize += entry.size;
+  }
+  sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+    return a.lastUse < b.lastUse;
+  });
+  for (const Entry &entry : entries) {
+    if (totalSize <= maxBytes_) break;
+    fs::remove(entry.path, ec);
+    totalSize -= entry.size;
+  }
+}
+
+} // End namespace minipart
@@ -11,44 +11,46 @@ using namespace std;
 namespace minipart {
 
 namespace {
-vector<Index> computePartitionDemands(const Hypergraph &hypergraph, const Solution &solution) {
-  vector<Index> ret(hypergraph.nParts(), 0);
+// The computations write to existing buffers so that their memory can be recycled
+void computePartitionDemands(const Hypergraph &hypergraph, const Solution &solution, vector<int64_t> &ret) {
+  ret.assign(hypergraph.nParts(), 0);
   for (Index node = 0; node < hypergraph.nNodes(); ++node) {
     ret[solution[node]] += hypergraph.nodeWeight(node);
   }
-  return ret;
 }
 
-vector<vector<Index> > computeHedgeNbPinsPerPartition(const Hypergraph &hypergraph, const Solution &solution) {
-  vector<vector<Index> > ret(hypergraph.nHedges());
-  for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
-    vector<Index> cnt(hypergraph.nParts());
-    for (Index node : hypergraph.hedgeNodes(hedge)) {
-      ++cnt[solution[node]];
+void computeHedgeNbPinsPerPartition(const Hypergraph &hypergraph, const Solution &solution, vector<Index> &ret) {
+  Index nParts = hypergraph.nParts();
+  ret.assign((size_t) hypergraph.nHedges() * nParts, 0);
+  hypergraph.visitPins([&](auto layout) {
+    for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
+      Index *cnt = ret.data() + (size_t) hedge * nParts;
+      for (Index node : hypergraph.hedgeNodes(hedge, layout)) {
+        ++cnt[solution[node]];
+      }
     }
-    ret[hedge] = cnt;
-  }
-  return ret;
+  });
 }
 
-vector<Index> computeHedgeDegrees(const Hypergraph &hypergraph, const vector<vector<Index> > &hedgeNbPinsPerPartition) {
-  vector<Index> ret(hypergraph.nHedges());
+void computeHedgeDegrees(const Hypergraph &hypergraph, const vector<Index> &hedgeNbPinsPerPartition, vector<Index> &ret) {
+  Index nParts = hypergraph.nParts();
+  ret.resize(hypergraph.nHedges());
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
+    const Index *cnt = hedgeNbPinsPerPartition.data() + (size_t) hedge * nParts;
     Index degree = 0;
-    for (Index cnt : hedgeNbPinsPerPartition[hedge]) {
-      if (cnt != 0) ++degree;
+    for (Index p = 0; p < nParts; ++p) {
+      if (cnt[p] != 0) ++degree;
     }
     ret[hedge] = degree;
   }
-  return ret;
 }
 
-vector<Index> computePartitionDegrees(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees, const vector<vector<Index> > &hedgeNbPinsPerPartition) {
-  vector<Index> ret(hypergraph.nParts(), 0);
+vector<int64_t> computePartitionDegrees(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees, const vector<Index> &hedgeNbPinsPerPartition) {
+  vector<int64_t> ret(hypergraph.nParts(), 0);
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
     if (hedgeDegrees[hedge] > 1) {
       for (Index p = 0; p < hypergraph.nParts(); ++p) {
-        if (hedgeNbPinsPerPartition[hedge][p] != 0) {
+        if (hedgeNbPinsPerPartition[(size_t) hedge * hypergraph.nParts() + p] != 0) {
           ret[p] += hypergraph.hedgeWeight(hedge);
         }
       }
@@ -57,13 +59,13 @@ vector<Index> computePartitionDegrees(const Hypergraph &hypergraph, const vector
   return ret;
 }
 
-vector<pair<Index, Index> > computeDaisyChainMinMax(const Hypergraph &hypergraph, const vector<vector<Index> > &hedgeNbPinsPerPartition) {
+vector<pair<Index, Index> > computeDaisyChainMinMax(const Hypergraph &hypergraph, const vector<Index> &hedgeNbPinsPerPartition) {
   vector<pair<Index, Index> > ret(hypergraph.nHedges());
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
     Index minPart = hypergraph.nParts() - 1;
     Index maxPart = 0;
     for (Index p = 0; p < hypergraph.nParts(); ++p) {
-      if (hedgeNbPinsPerPartition[hedge][p] != 0) {
+      if (hedgeNbPinsPerPartition[(size_t) hedge * hypergraph.nParts() + p] != 0) {
         minPart = min(minPart, p);
         maxPart = max(maxPart, p);
       }
@@ -73,18 +75,18 @@ vector<pair<Index, Index> > computeDaisyChainMinMax(const Hypergraph &hypergraph
   return ret;
 }
 
-Index computeDaisyChainDistance(const Hypergraph &hypergraph, const vector<pair<Index, Index> > &hedgeMinMax) {
-  Index distance = 0;
+int64_t computeDaisyChainDistance(const Hypergraph &hypergraph, const vector<pair<Index, Index> > &hedgeMinMax) {
+  int64_t distance = 0;
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
     Index minPart = hedgeMinMax[hedge].first;
     Index maxPart = hedgeMinMax[hedge].second;
-    distance += hypergraph.hedgeWeight(hedge) * (maxPart - minPart);
+    distance += (int64_t) hypergraph.hedgeWeight(hedge) * (maxPart - minPart);
   }
   return distance;
 }
 
-vector<Index> computeDaisyChainPartitionDegrees(const Hypergraph &hypergraph, const vector<pair<Index, Index> > &hedgeMinMax) {
-  vector<Index> ret(hypergraph.nParts(), 0);
+vector<int64_t> computeDaisyChainPartitionDegrees(const Hypergraph &hypergraph, const vector<pair<Index, Index> > &hedgeMinMax) {
+  vector<int64_t> ret(hypergraph.nParts(), 0);
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
     Index minPart = hedgeMinMax[hedge].first;
     Index maxPart = hedgeMinMax[hedge].second;
@@ -96,8 +98,8 @@ vector<Index> computeDaisyChainPartitionDegrees(const Hypergraph &hypergraph, co
   return ret;
 }
 
-Index computeCut(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees) {
-  Index ret = 0;
+int64_t computeCut(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees) {
+  int64_t ret = 0;
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
     if (hedgeDegrees[hedge] > 1)
       ret += hypergraph.hedgeWeight(hedge);
@@ -105,199 +107,183 @@ Index computeCut(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees
   return ret;
 }
 
-Index computeSoed(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees) {
-  Index ret = 0;
+int64_t computeSoed(const Hypergraph &hypergraph, const vector<Index> &hedgeDegrees) {
+  int64_t ret = 0;
   for (Index hedge = 0; hedge < hypergraph.nHedges(); ++hedge) {
-    ret += hypergraph.hedgeWeight(hedge) * hedgeDegrees[hedge];
+    ret += (int64_t) hypergraph.hedgeWeight(hedge) * hedgeDegrees[hedge];
   }
   return ret;
 }
 
-Index computeSumOverflow(const Hypergraph &hypergraph, const vector<Index> &partitionDemands) {
-  Index ret = 0;
+int64_t computeSumOverflow(const Hypergraph &hypergraph, const vector<int64_t> &partitionDemands) {
+  int64_t ret = 0;
   for (Index p = 0; p < hypergraph.nParts(); ++p) {
-    ret += max(partitionDemands[p] - hypergraph.partWeight(p), (Index) 0);
+    ret += max(partitionDemands[p] - hypergraph.partWeight(p), (int64_t) 0);
   }
   return ret;
 }
 
-Index countEmptyPartitions(const Hypergraph &hypergraph, const vector<Index> &partitionDemands) {
+Index countEmptyPartitions(const Hypergraph &hypergraph, const vector<int64_t> &partitionDemands) {
   Index count = 0;
-  for (Index d : partitionDemands) {
+  for (int64_t d : partitionDemands) {
     if (d == 0) count++;
   }
   return count;
 }
 
-double computeRatioPenalty(const Hypergraph &hypergraph, const vector<Index> &partitionDemands) {
-  Index sumDemands = 0;
-  for (Index d : partitionDemands)
+double computeRatioPenalty(const Hypergraph &hypergraph, const vector<int64_t> &partitionDemands) {
+  int64_t sumDemands = 0;
+  for (int64_t d : partitionDemands)
     sumDemands += d;
   double normalizedDemands = ((double) sumDemands) / partitionDemands.size();
   double productDemands = 1.0;
-  for (Index d : partitionDemands) {
+  for (int64_t d : partitionDemands) {
     productDemands *= (d / normalizedDemands);
   }
   // Geomean squared
   return 1.0 / pow(productDemands, 2.0 / partitionDemands.size());
 }
 
-Index computeMaxDegree(const Hypergraph &, const vector<Index> &partitionDegrees) {
+int64_t computeMaxDegree(const Hypergraph &, const vector<int64_t> &partitionDegrees) {
   return *max_element(partitionDegrees.begin(), partitionDegrees.end());
 }
 }
 
-IncrementalObjective::IncrementalObjective(const Hypergraph &hypergraph, Solution &solution, Index nObjectives)
+IncrementalObjective::IncrementalObjective(const Hypergraph &hypergraph, Solution &solution, Index nObjectives, BufferPool *pool)
 : hypergraph_(hypergraph)
 , solution_(solution)
-, objectives_(nObjectives, 0) {
+, objectives_(nObjectives, 0)
+, pool_(pool) {
   assert (hypergraph_.nNodes() == solution_.nNodes());
   assert (hypergraph_.nParts() == solution_.nParts());
+  if (pool_) {
+    // Request the real sizes, so that the largest buffer goes to the largest array
+    hedgeNbPinsPerPartition_ = pool_->get((size_t) hypergraph.nHedges() * hypergraph.nParts());
+    hedgeDegrees_ = pool_->get(hypergraph.nHedges());
+  }
+  computePartitionDemands(hypergraph, solution, partitionDemands_);
+  computeHedgeNbPinsPerPartition(hypergraph, solution, hedgeNbPinsPerPartition_);
+  computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_, hedgeDegrees_);
 }
 
-void IncrementalObjective::checkConsistency() const {
+IncrementalObjective::~IncrementalObjective() {
+  if (pool_) {
+    pool_->recycle(std::move(hedgeNbPinsPerPartition_));
+    pool_->recycle(std::move(hedgeDegrees_));
+  }
 }
 
-IncrementalCut::IncrementalCut(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+void IncrementalObjective::checkConsistency() const {
+  vector<int64_t> partitionDemands;
+  vector<Index> hedgeNbPinsPerPartition, hedgeDegrees;
+  computePartitionDemands(hypergraph_, solution_, partitionDemands);
+  computeHedgeNbPinsPerPartition(hypergraph_, solution_, hedgeNbPinsPerPartition);
+  computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_, hedgeDegrees);
+  assert (partitionDemands_ == partitionDemands);
+  assert (hedgeNbPinsPerPartition_ == hedgeNbPinsPerPartition);
+  assert (hedgeDegrees_ == hedgeDegrees);
+}
+
+IncrementalCut::IncrementalCut(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   currentCut_ = computeCut(hypergraph, hedgeDegrees_);
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalSoed::IncrementalSoed(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 2) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalSoed::IncrementalSoed(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 2, pool) {
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalMaxDegree::IncrementalMaxDegree(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalMaxDegree::IncrementalMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   partitionDegrees_ = computePartitionDegrees(hypergraph, hedgeDegrees_, hedgeNbPinsPerPartition_);
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalDaisyChainDistance::IncrementalDaisyChainDistance(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalDaisyChainDistance::IncrementalDaisyChainDistance(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   hedgeMinMax_ = computeDaisyChainMinMax(hypergraph, hedgeNbPinsPerPartition_);
   currentDistance_ = computeDaisyChainDistance(hypergraph, hedgeMinMax_);
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalDaisyChainMaxDegree::IncrementalDaisyChainMaxDegree(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalDaisyChainMaxDegree::IncrementalDaisyChainMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   hedgeMinMax_ = computeDaisyChainMinMax(hypergraph, hedgeNbPinsPerPartition_);
   partitionDegrees_ = computeDaisyChainPartitionDegrees(hypergraph, hedgeMinMax_);
   currentDistance_ = computeDaisyChainDistance(hypergraph, hedgeMinMax_);
   setObjective();
 }
 
-IncrementalRatioCut::IncrementalRatioCut(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 4) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalRatioCut::IncrementalRatioCut(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 4, pool) {
   currentCut_ = computeCut(hypergraph, hedgeDegrees_);
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalRatioSoed::IncrementalRatioSoed(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalRatioSoed::IncrementalRatioSoed(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
-IncrementalRatioMaxDegree::IncrementalRatioMaxDegree(const Hypergraph &hypergraph, Solution &solution)
-: IncrementalObjective(hypergraph, solution, 3) {
-  partitionDemands_ = computePartitionDemands(hypergraph, solution);
-  hedgeNbPinsPerPartition_ = computeHedgeNbPinsPerPartition(hypergraph, solution);
-  hedgeDegrees_ = computeHedgeDegrees(hypergraph, hedgeNbPinsPerPartition_);
+IncrementalRatioMaxDegree::IncrementalRatioMaxDegree(const Hypergraph &hypergraph, Solution &solution, BufferPool *pool)
+: IncrementalObjective(hypergraph, solution, 3, pool) {
   partitionDegrees_ = computePartitionDegrees(hypergraph, hedgeDegrees_, hedgeNbPinsPerPartition_);
   currentSoed_ = computeSoed(hypergraph, hedgeDegrees_);
   setObjective();
 }
 
 void IncrementalCut::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (currentCut_ == computeCut(hypergraph_, hedgeDegrees_));
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalSoed::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalMaxDegree::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (partitionDegrees_ == computePartitionDegrees(hypergraph_, hedgeDegrees_, hedgeNbPinsPerPartition_));
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalDaisyChainDistance::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (hedgeMinMax_ == computeDaisyChainMinMax(hypergraph_, hedgeNbPinsPerPartition_));
   assert (currentDistance_ == computeDaisyChainDistance(hypergraph_, hedgeMinMax_));
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalDaisyChainMaxDegree::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (hedgeMinMax_ == computeDaisyChainMinMax(hypergraph_, hedgeNbPinsPerPartition_));
   assert (currentDistance_ == computeDaisyChainDistance(hypergraph_, hedgeMinMax_));
   assert (partitionDegrees_ == computeDaisyChainPartitionDegrees(hypergraph_, hedgeMinMax_));
 }
 
 void IncrementalRatioCut::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (currentCut_ == computeCut(hypergraph_, hedgeDegrees_));
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalRatioSoed::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
 
 void IncrementalRatioMaxDegree::checkConsistency() const {
-  assert (partitionDemands_ == computePartitionDemands(hypergraph_, solution_));
-  assert (hedgeNbPinsPerPartition_ == computeHedgeNbPinsPerPartition(hypergraph_, solution_));
-  assert (hedgeDegrees_ == computeHedgeDegrees(hypergraph_, hedgeNbPinsPerPartition_));
+  IncrementalObjective::checkConsistency();
   assert (partitionDegrees_ == computePartitionDegrees(hypergraph_, hedgeDegrees_, hedgeNbPinsPerPartition_));
   assert (currentSoed_ == computeSoed(hypergraph_, hedgeDegrees_));
 }
@@ -358,25 +344,27 @@ void IncrementalCut::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 2) {
-        currentCut_ += hypergraph_.hedgeWeight(hedge);
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 2) {
+          currentCut_ += hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 1) {
-        currentCut_ -= hypergraph_.hedgeWeight(hedge);
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 1) {
+          currentCut_ -= hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
     }
-  }
+  });
   setObjective();
 }
 
@@ -388,19 +376,21 @@ void IncrementalSoed::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
+      }
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
+      }
     }
-  }
+  });
   setObjective();
 }
 
@@ -412,44 +402,46 @@ void IncrementalMaxDegree::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    bool becomesCut = false;
-    bool becomesUncut = false;
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 2) {
-        becomesCut = true;
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      bool becomesCut = false;
+      bool becomesUncut = false;
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 2) {
+          becomesCut = true;
+        }
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 1) {
-        becomesUncut = true;
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 1) {
+          becomesUncut = true;
+        }
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
-    }
 
-    if (becomesUncut) {
-      partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
-      partitionDegrees_[to] -= hypergraph_.hedgeWeight(hedge);
-    }
-    else if (becomesCut) {
-      partitionDegrees_[from] += hypergraph_.hedgeWeight(hedge);
-      partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
-    }
-    else if (hedgeDegrees_[hedge] >= 2) {
-      if (pins[from] == 0) {
+      if (becomesUncut) {
         partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
+        partitionDegrees_[to] -= hypergraph_.hedgeWeight(hedge);
       }
-      if (pins[to] == 1) {
+      else if (becomesCut) {
+        partitionDegrees_[from] += hypergraph_.hedgeWeight(hedge);
         partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
       }
+      else if (hedgeDegrees_[hedge] >= 2) {
+        if (pins[from] == 0) {
+          partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
+        }
+        if (pins[to] == 1) {
+          partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
+        }
+      }
     }
-  }
+  });
   setObjective();
 }
 
@@ -461,36 +453,38 @@ void IncrementalDaisyChainDistance::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    bool reachesPart = pins[to] == 1;
-    bool leavesPart = pins[from] == 0;
-    if (reachesPart) {
-      ++hedgeDegrees_[hedge];
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (leavesPart) {
-      --hedgeDegrees_[hedge];
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
-    }
-    if (reachesPart || leavesPart) {
-      Index minAfter = nParts() - 1;
-      Index maxAfter = 0;
-      for (Index p = 0; p < nParts(); ++p) {
-        bool countsAfter = pins[p] != 0;
-        if (countsAfter) {
-          minAfter = min(minAfter, p);
-          maxAfter = max(maxAfter, p);
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      bool reachesPart = pins[to] == 1;
+      bool leavesPart = pins[from] == 0;
+      if (reachesPart) {
+        ++hedgeDegrees_[hedge];
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
+      }
+      if (leavesPart) {
+        --hedgeDegrees_[hedge];
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
+      }
+      if (reachesPart || leavesPart) {
+        Index minAfter = nParts() - 1;
+        Index maxAfter = 0;
+        for (Index p = 0; p < nParts(); ++p) {
+          bool countsAfter = pins[p] != 0;
+          if (countsAfter) {
+            minAfter = min(minAfter, p);
+            maxAfter = max(maxAfter, p);
+          }
         }
+        Index minBefore = hedgeMinMax_[hedge].first;
+        Index maxBefore = hedgeMinMax_[hedge].second;
+        hedgeMinMax_[hedge] = make_pair(minAfter, maxAfter);
+        currentDistance_ += (int64_t) hypergraph_.hedgeWeight(hedge) * (maxAfter - minAfter - maxBefore + minBefore);
       }
-      Index minBefore = hedgeMinMax_[hedge].first;
-      Index maxBefore = hedgeMinMax_[hedge].second;
-      hedgeMinMax_[hedge] = make_pair(minAfter, maxAfter);
-      currentDistance_ += hypergraph_.hedgeWeight(hedge) * (maxAfter - minAfter - maxBefore + minBefore);
     }
-  }
+  });
   setObjective();
 }
 
@@ -502,45 +496,47 @@ void IncrementalDaisyChainMaxDegree::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    bool reachesPart = pins[to] == 1;
-    bool leavesPart = pins[from] == 0;
-    if (reachesPart) {
-      ++hedgeDegrees_[hedge];
-    }
-    if (leavesPart) {
-      --hedgeDegrees_[hedge];
-    }
-    if (reachesPart || leavesPart) {
-      Index minAfter = nParts() - 1;
-      Index maxAfter = 0;
-      for (Index p = 0; p < nParts(); ++p) {
-        bool countsAfter = pins[p] != 0;
-        if (countsAfter) {
-          minAfter = min(minAfter, p);
-          maxAfter = max(maxAfter, p);
-        }
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      bool reachesPart = pins[to] == 1;
+      bool leavesPart = pins[from] == 0;
+      if (reachesPart) {
+        ++hedgeDegrees_[hedge];
+      }
+      if (leavesPart) {
+        --hedgeDegrees_[hedge];
       }
-      Index minBefore = hedgeMinMax_[hedge].first;
-      Index maxBefore = hedgeMinMax_[hedge].second;
-      hedgeMinMax_[hedge] = make_pair(minAfter, maxAfter);
-      if (minAfter != minBefore || maxAfter != maxBefore) {
-        currentDistance_ += hypergraph_.hedgeWeight(hedge) * (maxAfter - minAfter - maxBefore + minBefore);
-        // Update degrees
-        for (Index p = minBefore; p < maxBefore; ++p) {
-          partitionDegrees_[p] -= hypergraph_.hedgeWeight(hedge);
-          partitionDegrees_[p+1] -= hypergraph_.hedgeWeight(hedge);
+      if (reachesPart || leavesPart) {
+        Index minAfter = nParts() - 1;
+        Index maxAfter = 0;
+        for (Index p = 0; p < nParts(); ++p) {
+          bool countsAfter = pins[p] != 0;
+          if (countsAfter) {
+            minAfter = min(minAfter, p);
+            maxAfter = max(maxAfter, p);
+          }
         }
-        for (Index p = minAfter; p < maxAfter; ++p) {
-          partitionDegrees_[p] += hypergraph_.hedgeWeight(hedge);
-          partitionDegrees_[p+1] += hypergraph_.hedgeWeight(hedge);
+        Index minBefore = hedgeMinMax_[hedge].first;
+        Index maxBefore = hedgeMinMax_[hedge].second;
+        hedgeMinMax_[hedge] = make_pair(minAfter, maxAfter);
+        if (minAfter != minBefore || maxAfter != maxBefore) {
+          currentDistance_ += (int64_t) hypergraph_.hedgeWeight(hedge) * (maxAfter - minAfter - maxBefore + minBefore);
+          // Update degrees
+          for (Index p = minBefore; p < maxBefore; ++p) {
+            partitionDegrees_[p] -= hypergraph_.hedgeWeight(hedge);
+            partitionDegrees_[p+1] -= hypergraph_.hedgeWeight(hedge);
+          }
+          for (Index p = minAfter; p < maxAfter; ++p) {
+            partitionDegrees_[p] += hypergraph_.hedgeWeight(hedge);
+            partitionDegrees_[p+1] += hypergraph_.hedgeWeight(hedge);
+          }
         }
       }
     }
-  }
+  });
   setObjective();
 }
 
@@ -552,25 +548,27 @@ void IncrementalRatioCut::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 2) {
-        currentCut_ += hypergraph_.hedgeWeight(hedge);
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 2) {
+          currentCut_ += hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 1) {
-        currentCut_ -= hypergraph_.hedgeWeight(hedge);
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 1) {
+          currentCut_ -= hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
     }
-  }
+  });
   setObjective();
 }
 
@@ -582,25 +580,27 @@ void IncrementalRatioSoed::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 2) {
-        currentCut_ += hypergraph_.hedgeWeight(hedge);
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 2) {
+          currentCut_ += hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 1) {
-        currentCut_ -= hypergraph_.hedgeWeight(hedge);
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 1) {
+          currentCut_ -= hypergraph_.hedgeWeight(hedge);
+        }
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
     }
-  }
+  });
   setObjective();
 }
 
@@ -612,44 +612,46 @@ void IncrementalRatioMaxDegree::move(Index node, Index to) {
   partitionDemands_[to]   += hypergraph_.nodeWeight(node);
   partitionDemands_[from] -= hypergraph_.nodeWeight(node);
 
-  for (Index hedge : hypergraph_.nodeHedges(node)) {
-    vector<Index> &pins = hedgeNbPinsPerPartition_[hedge];
-    ++pins[to];
-    --pins[from];
-    bool becomesCut = false;
-    bool becomesUncut = false;
-    if (pins[to] == 1 && pins[from] != 0) {
-      ++hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 2) {
-        becomesCut = true;
+  hypergraph_.visitPins([&](auto layout) {
+    for (Index hedge : hypergraph_.nodeHedges(node, layout)) {
+      Index *pins = hedgePins(hedge);
+      ++pins[to];
+      --pins[from];
+      bool becomesCut = false;
+      bool becomesUncut = false;
+      if (pins[to] == 1 && pins[from] != 0) {
+        ++hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 2) {
+          becomesCut = true;
+        }
+        currentSoed_ += hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ += hypergraph_.hedgeWeight(hedge);
-    }
-    if (pins[to] != 1 && pins[from] == 0) {
-      --hedgeDegrees_[hedge];
-      if (hedgeDegrees_[hedge] == 1) {
-        becomesUncut = true;
+      if (pins[to] != 1 && pins[from] == 0) {
+        --hedgeDegrees_[hedge];
+        if (hedgeDegrees_[hedge] == 1) {
+          becomesUncut = true;
+        }
+        currentSoed_ -= hypergraph_.hedgeWeight(hedge);
       }
-      currentSoed_ -= hypergraph_.hedgeWeight(hedge);
-    }
 
-    if (becomesUncut) {
-      partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
-      partitionDegrees_[to] -= hypergraph_.hedgeWeight(hedge);
-    }
-    else if (becomesCut) {
-      partitionDegrees_[from] += hypergraph_.hedgeWeight(hedge);
-      partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
-    }
-    else if (hedgeDegrees_[hedge] >= 2) {
-      if (pins[from] == 0) {
+      if (becomesUncut) {
         partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
+        partitionDegrees_[to] -= hypergraph_.hedgeWeight(hedge);
       }
-      if (pins[to] == 1) {
+      else if (becomesCut) {
+        partitionDegrees_[from] += hypergraph_.hedgeWeight(hedge);
         partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
       }
+      else if (hedgeDegrees_[hedge] >= 2) {
+        if (pins[from] == 0) {
+          partitionDegrees_[from] -= hypergraph_.hedgeWeight(hedge);
+        }
+        if (pins[to] == 1) {
+          partitionDegrees_[to] += hypergraph_.hedgeWeight(hedge);
+        }
+      }
     }
-  }
+  });
   setObjective();
 }
 
@@ -2,15 +2,22 @@
 
 #include "hypergraph.hh"
 #include "solution.hh"
+#include "trace.hh"
+#include "parallel.hh"
+#include "gzip.hh"
 
 #include <memory>
-#include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <fstream>
-#include <boost/iostreams/filtering_streambuf.hpp>
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
+#include <sstream>
+#include <limits>
+#include <cstring>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -18,28 +25,305 @@ namespace minipart {
 
 namespace {
 
-stringstream getUncommentedLine(istream &s) {
-  // Get rid of comment lines and empty lines
-  string tmp;
-  do {
-    if (!s.good()) throw runtime_error("Not enough lines");
-    getline(s, tmp);
-  } while(tmp.empty() || tmp[0] == '%');
+/**
+ * Reader for line-based text formats, working in place on the file contents
+ *
+ * Comment lines and empty lines are skipped. Integers are parsed as operator>> would:
+ * after the first invalid token, every read on the line fails.
+ */
+class TextReader {
+ public:
+  TextReader(const char *begin, const char *end)
+    : next_(begin), end_(end), pos_(begin), lineEnd_(begin) {}
+
+  void nextLine() {
+    const char *lineBegin;
+    do {
+      if (next_ == end_) throw runtime_error("Not enough lines");
+      lineBegin = next_;
+      const char *newline = (const char *) memchr(next_, '\n', end_ - next_);
+      lineEnd_ = newline != nullptr ? newline : end_;
+      next_ = newline != nullptr ? newline + 1 : end_;
+    } while (isSkipped(lineBegin, lineEnd_));
+    pos_ = lineBegin;
+  }
+
+  // Start of the lines that were not read yet
+  const char *remaining() const {
+    return next_;
+  }
+
+  // Number of lines that are neither empty nor comments
+  static int64_t countLines(const char *begin, const char *end) {
+    int64_t ret = 0;
+    while (begin != end) {
+      const char *newline = (const char *) memchr(begin, '\n', end - begin);
+      const char *lineEnd = newline != nullptr ? newline : end;
+      if (!isSkipped(begin, lineEnd)) ++ret;
+      begin = newline != nullptr ? newline + 1 : end;
+    }
+    return ret;
+  }
+
+  bool read(Index &value) {
+    while (pos_ != lineEnd_ && isSpace(*pos_)) ++pos_;
+    bool negative = false;
+    if (pos_ != lineEnd_ && (*pos_ == '-' || *pos_ == '+')) {
+      negative = *pos_ == '-';
+      ++pos_;
+    }
+    if (pos_ == lineEnd_ || !isDigit(*pos_)) return fail();
+    int64_t v = 0;
+    bool overflow = false;
+    for (; pos_ != lineEnd_ && isDigit(*pos_); ++pos_) {
+      v = 10 * v + (*pos_ - '0');
+      if (v > (int64_t) 1 << 32) {
+        overflow = true;
+        v = 0;
+      }
+    }
+    if (negative) v = -v;
+    if (overflow || v > numeric_limits<Index>::max() || v < numeric_limits<Index>::min()) return fail();
+    value = v;
+    return true;
+  }
+
+ private:
+  static bool isSkipped(const char *lineBegin, const char *lineEnd) {
+    return lineBegin == lineEnd || *lineBegin == '%';
+  }
+
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  bool fail() {
+    pos_ = lineEnd_;
+    return false;
+  }
+
+ private:
+  const char *next_;
+  const char *end_;
+  const char *pos_;
+  const char *lineEnd_;
+};
+
+/**
+ * Contents of a file, memory-mapped if it is a regular file
+ */
+class FileContents {
+ public:
+  explicit FileContents(const string &name) {
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Unable to open the file \"" + name + "\"");
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        mapped_ = (const char *) data;
+        size_ = st.st_size;
+      }
+    }
+    if (mapped_ == nullptr) {
+      char buffer[1 << 16];
+      ssize_t n;
+      while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        copy_.append(buffer, n);
+      }
+    }
+    close(fd);
+  }
+
+  ~FileContents() {
+    if (mapped_ != nullptr) munmap((void *) mapped_, size_);
+  }
+
+  FileContents(const FileContents &) = delete;
+  FileContents &operator=(const FileContents &) = delete;
+
+  const char *begin() const { return mapped_ != nullptr ? mapped_ : copy_.data(); }
+  const char *end() const { return mapped_ != nullptr ? mapped_ + size_ : copy_.data() + copy_.size(); }
+
+ private:
+  const char *mapped_ = nullptr;
+  size_t size_ = 0;
+  string copy_;
+};
+
+/**
+ * Split a buffer in chunks of whole lines, of at least one megabyte each
+ */
+vector<const char *> splitLines(const char *begin, const char *end) {
+  Index sizeKb = min((int64_t) (end - begin) / 1024, (int64_t) numeric_limits<Index>::max());
+  Index nc = nChunks(sizeKb, 1024);
+  vector<const char *> ret(nc + 1, end);
+  ret[0] = begin;
+  for (Index c = 1; c < nc; ++c) {
+    const char *pos = max(ret[c-1], begin + (end - begin) * c / nc);
+    const char *newline = (const char *) memchr(pos, '\n', end - pos);
+    ret[c] = newline != nullptr ? newline + 1 : end;
+  }
+  return ret;
+}
+
+/**
+ * Formats integers into a large buffer, written to the stream in big blocks
+ */
+class TextWriter {
+ public:
+  explicit TextWriter(ostream &s)
+    : s_(s), buffer_(1 << 20), pos_(0) {}
+
+  ~TextWriter() {
+    flush();
+  }
+
+  void write(Index value) {
+    if (buffer_.size() - pos_ < 12) flush();
+    char digits[12];
+    int nDigits = 0;
+    uint32_t v = value < 0 ? -(uint32_t) value : value;
+    do {
+      digits[nDigits++] = '0' + v % 10;
+      v /= 10;
+    } while (v != 0);
+    if (value < 0) buffer_[pos_++] = '-';
+    while (nDigits > 0) buffer_[pos_++] = digits[--nDigits];
+  }
+
+  void write(char c) {
+    if (pos_ == buffer_.size()) flush();
+    buffer_[pos_++] = c;
+  }
+
+  void write(const char *str) {
+    for (; *str != '\0'; ++str) write(*str);
+  }
+
+  void flush() {
+    s_.write(buffer_.data(), pos_);
+    pos_ = 0;
+  }
 
-  return stringstream(tmp);
+ private:
+  ostream &s_;
+  vector<char> buffer_;
+  size_t pos_;
+};
+
+/**
+ * Header of the binary format, followed by the arrays of the hypergraph
+ *
+ * Fields are stored in the native byte order, checked with byteOrder.
+ * Arrays start on 64-byte boundaries; the checksum covers their contents.
+ */
+const char mgbMagic[4] = {'M', 'P', 'H', 'G'};
+const uint32_t mgbVersion = 3;
+const uint32_t byteOrderMark = 0x01020304;
+const char msbMagic[4] = {'M', 'P', 'S', 'L'};
+const uint32_t msbVersion = 1;
+const int64_t mgbAlignment = 64;
+const int mgbArrays = 7;
+
+struct MgbHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t indexSize;
+  uint32_t offsetSize;
+  uint32_t reserved;
+  int64_t nNodes;
+  int64_t nHedges;
+  int64_t nParts;
+  int64_t nPins;
+  int64_t nNodeWeights;
+  int64_t nHedgeWeights;
+  int64_t nPartWeights;
+  // Position in the file and number of elements of nodeBegin, nodePins, hedgeBegin, hedgePins,
+  // nodeWeights, hedgeWeights and partData
+  // The begin arrays hold Offset elements, the others Index elements
+  int64_t arrayOffset[mgbArrays];
+  int64_t arraySize[mgbArrays];
+  uint64_t checksum;
+};
+
+/**
+ * Header of the binary solution format, followed by the part of each node
+ *
+ * Parts are stored on 1, 2 or 4 bytes depending on the number of parts.
+ */
+struct MsbHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t partBytes;
+  int64_t nNodes;
+  int64_t nParts;
+  uint64_t checksum;
+};
+
+uint64_t binaryChecksum(uint64_t hash, const char *data, size_t size) {
+  // FNV-style hash on 64-bit words
+  uint64_t magic = 1099511628211llu;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * magic;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ (uint64_t) (unsigned char) data[i]) * magic;
+  }
+  return hash;
+}
+
+/**
+ * Read one array of a binary hypergraph, checking its bounds and accumulating its checksum
+ */
+template<typename T>
+void readMgbArray(const char *begin, const char *end, const MgbHeader &header, int i, vector<T> &array, uint64_t &checksum) {
+  int64_t offset = header.arrayOffset[i];
+  int64_t size = header.arraySize[i];
+  if (offset < (int64_t) sizeof(header) || offset > end - begin || size < 0 || size > (end - begin - offset) / (int64_t) sizeof(T)) {
+    throw runtime_error("Truncated binary hypergraph file");
+  }
+  const char *data = begin + offset;
+  checksum = binaryChecksum(checksum, data, size * sizeof(T));
+  array.resize(size);
+  memcpy(array.data(), data, size * sizeof(T));
+}
+
+string readContents(istream &s) {
+  string ret;
+  char buffer[1 << 16];
+  while (s) {
+    s.read(buffer, sizeof(buffer));
+    ret.append(buffer, s.gcount());
+  }
+  return ret;
 }
 
 } // End anonymous namespace
 
 
 Hypergraph Hypergraph::readHgr(istream &s) {
+  string contents = readContents(s);
+  return readHgr(contents.data(), contents.data() + contents.size());
+}
+
+Hypergraph Hypergraph::readHgr(const char *begin, const char *end) {
   Index nNodes, nHedges, params;
 
-  stringstream ss = getUncommentedLine(s);
-  ss >> nHedges >> nNodes;
-  if (ss.fail()) throw runtime_error("Invalid first line");
-  ss >> params;
-  if (ss.fail()) params = 0;
+  TextReader header(begin, end);
+  header.nextLine();
+  if (!header.read(nHedges) || !header.read(nNodes)) throw runtime_error("Invalid first line");
+  if (!header.read(params)) params = 0;
 
   if (params != 0 && params != 1 && params != 10 && params != 11) throw runtime_error("Invalid parameter value");
 
@@ -52,55 +336,68 @@ Hypergraph Hypergraph::readHgr(istream &s) {
   ret.nHedges_ = nHedges;
   ret.nParts_ = 0;
 
-  // Read edges
-  ret.hedgeBegin_.reserve(nHedges);
-  ret.hedgeData_.reserve(3 * nHedges);
-  vector<Index> nodes;
-  for (Index i = 0; i < nHedges; ++i) {
-    ss = getUncommentedLine(s);
+  // Split the rest of the file in chunks, and find the index of the first line of each chunk
+  // The last chunk is not counted: it reads until it has all the lines or reaches the end of the file
+  vector<const char *> chunks = splitLines(header.remaining(), end);
+  Index nc = chunks.size() - 1;
+  vector<int64_t> firstLine(nc + 1, 0);
+  if (nc > 1) {
+    parallelChunks(nc - 1, nc - 1, [&](Index c, Index, Index) {
+      firstLine[c+1] = TextReader::countLines(chunks[c], chunks[c+1]);
+    });
+  }
+  for (Index c = 0; c < nc; ++c) {
+    firstLine[c+1] += firstLine[c];
+  }
+  int64_t nLines = (int64_t) nHedges + (hasNodeWeights ? nNodes : 0);
+  firstLine[nc] = max(firstLine[nc - 1], nLines);
+
+  // Read edges and node weights into per-chunk fragments, sorting the pins in place
+  vector<vector<Offset> > fragmentBegins(nc);
+  vector<vector<Index> > fragmentData(nc);
+  vector<vector<Index> > fragmentWeights(nc);
+  vector<vector<Index> > fragmentNodeData(nc);
+  parallelChunks(nc, nc, [&](Index c, Index, Index) {
+    TextReader r(chunks[c], chunks[c+1]);
+    vector<Offset> &begins = fragmentBegins[c];
+    vector<Index> &data = fragmentData[c];
+    int64_t lastLine = min(firstLine[c+1], nLines);
+    for (int64_t line = firstLine[c]; line < lastLine; ++line) {
+      r.nextLine();
+      if (line >= nHedges) {
+        Index w, extra;
+        if (!r.read(w) || r.read(extra)) throw runtime_error("All nodes should have exactly one weight");
+        fragmentNodeData[c].push_back(w);
+        continue;
+      }
 
-    Index w = 1;
-    if (hasHedgeWeights) ss >> w;
+      Index w = 1;
+      if (hasHedgeWeights) r.read(w);
+      fragmentWeights[c].push_back(w);
+      size_t firstPin = data.size();
 
-    while (ss) {
-        Index n;
-        ss >> n;
-        if (ss.fail()) continue;
+      Index n;
+      while (r.read(n)) {
         if (n > nNodes) throw runtime_error("Parsed pin index is outside the specified number of nodes");
         if (n <= 0) throw runtime_error("Parsed pin index must be strictly positive");
-        nodes.push_back(n-1);
+        data.push_back(n-1);
+      }
+      auto pinsBegin = data.begin() + firstPin;
+      sort(pinsBegin, data.end());
+      data.erase(unique(pinsBegin, data.end()), data.end());
+      if (data.size() == firstPin) throw runtime_error("No node on the line");
+      begins.push_back(data.size());
     }
-    sort(nodes.begin(), nodes.end());
-    nodes.resize(unique(nodes.begin(), nodes.end()) - nodes.begin());
-    if (nodes.empty()) throw runtime_error("No node on the line");
-    ret.hedgeData_.push_back(w);
-    ret.hedgeData_.insert(ret.hedgeData_.end(), nodes.begin(), nodes.end());
-    ret.hedgeBegin_.push_back(ret.hedgeData_.size());
-    nodes.clear();
-  }
+  });
+  concatenateFragments(fragmentBegins, fragmentData, ret.hedgeBegin_, ret.hedgePins_);
+  concatenateWeights(fragmentWeights, 1, ret.hedgeWeights_);
 
-  // Read node weights
-  ret.nodeData_.reserve(nNodes + ret.hedgeData_.size() - nHedges);
+  // Node weights
   if (hasNodeWeights) {
-    vector<Index> demands;
-    for (Index i = 0; i < nNodes; ++i) {
-      ss = getUncommentedLine(s);
-      while (ss) {
-        Index w;
-        ss >> w;
-        if (ss.fail()) continue;
-        demands.push_back(w);
-      }
-      if (demands.size() != 1) throw runtime_error("All nodes should have exactly one weight");
-      ret.nodeData_.push_back(demands.front());
-      demands.clear();
-    }
+    concatenateWeights(fragmentNodeData, 1, ret.nodeWeights_);
   }
   else {
-    ret.nodeData_.assign(nNodes, 1);
-  }
-  for (Index i = 1; i <= nNodes; ++i) {
-    ret.nodeBegin_.push_back(i);
+    ret.nodeWeights_.assign(nNodes, 1);
   }
 
   // Finalize nodes 
@@ -125,30 +422,42 @@ void Hypergraph::writeHgr(ostream &s) const {
   s << "%\n";
   s << "%\n";
 
-  s << nHedges() << " " << nNodes_ << " 11\n";
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    s << hedgeWeight(hedge);
-    for (Index node : hedgeNodes(hedge)) {
-      s << " " << node + 1;
+  TextWriter w(s);
+  w.write(nHedges());
+  w.write(' ');
+  w.write(nNodes_);
+  w.write(" 11\n");
+  visitPins([&](auto layout) {
+    for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+      w.write(hedgeWeight(hedge));
+      for (Index node : hedgeNodes(hedge, layout)) {
+        w.write(' ');
+        w.write(node + 1);
+      }
+      w.write('\n');
     }
-    s << "\n";
-  }
+  });
   for (Index node = 0; node < nNodes_; ++node) {
-    s << nodeWeight(node) << "\n";
+    w.write(nodeWeight(node));
+    w.write('\n');
   }
 }
 
 Hypergraph Hypergraph::readMinipart(istream &s) {
+  string contents = readContents(s);
+  return readMinipart(contents.data(), contents.data() + contents.size());
+}
+
+Hypergraph Hypergraph::readMinipart(const char *begin, const char *end) {
   Index nNodes, nHedges, nParts;
   Index nNodeWeights, nHedgeWeights, nPartWeights;
-  stringstream ss = getUncommentedLine(s);
-  ss >> nNodes >> nHedges >> nParts;
-  if (ss.fail()) throw runtime_error("Invalid first line");
-  ss = getUncommentedLine(s);
-  ss >> nNodeWeights >> nHedgeWeights >> nPartWeights;
-  if (ss.fail()) throw runtime_error("Invalid second line");
-
-  vector<Index> hedgeBegin;
+  TextReader r(begin, end);
+  r.nextLine();
+  if (!r.read(nNodes) || !r.read(nHedges) || !r.read(nParts)) throw runtime_error("Invalid first line");
+  r.nextLine();
+  if (!r.read(nNodeWeights) || !r.read(nHedgeWeights) || !r.read(nPartWeights)) throw runtime_error("Invalid second line");
+
+  vector<Offset> hedgeBegin;
   vector<Index> hedgeData;
   hedgeBegin.reserve(nHedges);
   hedgeData.reserve(3 * nHedges);
@@ -159,11 +468,9 @@ Hypergraph Hypergraph::readMinipart(istream &s) {
   // Pins
   for (Index i = 0; i < nHedges; ++i) {
     tmpVec.clear();
-    ss = getUncommentedLine(s);
-    while (ss) {
-        Index n;
-        ss >> n;
-        if (ss.fail()) continue;
+    r.nextLine();
+    Index n;
+    while (r.read(n)) {
         if (n > nNodes) throw runtime_error("Parsed pin index is outside the specified number of nodes");
         if (n <= 0) throw runtime_error("Parsed pin index must be strictly positive");
         tmpVec.push_back(n-1);
@@ -181,49 +488,44 @@ Hypergraph Hypergraph::readMinipart(istream &s) {
   ret.nParts_ = nParts;
 
   // Node weights
+  ret.nodeWeights_.resize((size_t) nNodes * nNodeWeights);
   for (Index i = 0; i < nNodes; ++i) {
     tmpVec.clear();
-    ss = getUncommentedLine(s);
-    while (ss) {
-      Index w;
-      ss >> w;
-      if (ss.fail()) continue;
+    r.nextLine();
+    Index w;
+    while (r.read(w)) {
       tmpVec.push_back(w);
     }
     if ((Index) tmpVec.size() != nNodeWeights) throw runtime_error("All nodes should have the prescribed number of weights");
-    ret.nodeData_.insert(ret.nodeData_.end(), tmpVec.begin(), tmpVec.end());
-  }
-  for (Index i = 1; i <= nNodes; ++i) {
-    ret.nodeBegin_.push_back(i * nNodeWeights);
+    for (Index j = 0; j < nNodeWeights; ++j) {
+      ret.nodeWeights_[(size_t) j * nNodes + i] = tmpVec[j];
+    }
   }
 
   // Hedge weights
+  ret.hedgeWeights_.resize((size_t) nHedges * nHedgeWeights);
   for (Index i = 0; i < nHedges; ++i) {
     tmpVec.clear();
-    ss = getUncommentedLine(s);
-    while (ss) {
-      Index w;
-      ss >> w;
-      if (ss.fail()) continue;
+    r.nextLine();
+    Index w;
+    while (r.read(w)) {
       tmpVec.push_back(w);
     }
     if ((Index) tmpVec.size() != nHedgeWeights) throw runtime_error("All hedges should have the prescribed number of weights");
-    ret.hedgeData_.insert(ret.hedgeData_.end(), tmpVec.begin(), tmpVec.end());
-    for (Index j = hedgeBegin[i]; j < hedgeBegin[i+1]; ++j) {
-      ret.hedgeData_.push_back(hedgeData[j]);
+    for (Index j = 0; j < nHedgeWeights; ++j) {
+      ret.hedgeWeights_[(size_t) j * nHedges + i] = tmpVec[j];
     }
-    ret.hedgeBegin_.push_back(ret.hedgeData_.size());
   }
+  ret.hedgeBegin_.swap(hedgeBegin);
+  ret.hedgePins_.swap(hedgeData);
 
   // Part weights
   ret.partData_.reserve(nParts * nPartWeights);
   for (Index i = 0; i < nParts; ++i) {
     tmpVec.clear();
-    ss = getUncommentedLine(s);
-    while (ss) {
-      Index w;
-      ss >> w;
-      if (ss.fail()) continue;
+    r.nextLine();
+    Index w;
+    while (r.read(w)) {
       tmpVec.push_back(w);
     }
     if ((Index) tmpVec.size() != nPartWeights) throw runtime_error("All parts should have the prescribed number of weights");
@@ -252,39 +554,165 @@ void Hypergraph::writeMinipart(ostream &s) const {
   s << nNodes_ << " " << nHedges_ << " " << nParts_ << "\n";
   s << nNodeWeights_ << " " << nHedgeWeights_ << " " << nPartWeights_ << "\n";
 
-  s << "% hedge pins\n";
-  for (Index hedge = 0; hedge < nHedges_; ++hedge) {
-    bool first = true;
-    for (Index node : hedgeNodes(hedge)) {
-      s << (first ? "" : " ") << node + 1;
-      first = false;
+  TextWriter w(s);
+  w.write("% hedge pins\n");
+  visitPins([&](auto layout) {
+    for (Index hedge = 0; hedge < nHedges_; ++hedge) {
+      bool first = true;
+      for (Index node : hedgeNodes(hedge, layout)) {
+        if (!first) w.write(' ');
+        w.write(node + 1);
+        first = false;
+      }
+      w.write('\n');
     }
-    s << "\n";
-  }
+  });
 
-  s << "% node weights (" << nNodeWeights_ << " per node)\n";
+  w.write("% node weights (");
+  w.write(nNodeWeights_);
+  w.write(" per node)\n");
   for (Index node = 0; node < nNodes_; ++node) {
     for (Index i = 0; i < nNodeWeights_; ++i) {
-      s << (i == 0 ? "" : " ") << nodeWeight(node, i);
+      if (i != 0) w.write(' ');
+      w.write(nodeWeight(node, i));
     }
-    s << "\n";
+    w.write('\n');
   }
 
-  s << "% hedge weights (" << nHedgeWeights_ << " per hedge)\n";
+  w.write("% hedge weights (");
+  w.write(nHedgeWeights_);
+  w.write(" per hedge)\n");
   for (Index hedge = 0; hedge < nHedges_; ++hedge) {
     for (Index i = 0; i < nHedgeWeights_; ++i) {
-      s << (i == 0 ? "" : " ") << hedgeWeight(hedge, i);
+      if (i != 0) w.write(' ');
+      w.write(hedgeWeight(hedge, i));
     }
-    s << "\n";
+    w.write('\n');
   }
 
-  s << "% part weights (" << nPartWeights_ << " per part)\n";
+  w.write("% part weights (");
+  w.write(nPartWeights_);
+  w.write(" per part)\n");
   for (Index part = 0; part < nParts_; ++part) {
     for (Index i = 0; i < nPartWeights_; ++i) {
-      s << (i == 0 ? "" : " ") << partWeight(part, i);
+      if (i != 0) w.write(' ');
+      w.write(partWeight(part, i));
     }
-    s << "\n";
+    w.write('\n');
+  }
+}
+
+Hypergraph Hypergraph::readMgb(const char *begin, const char *end) {
+  MgbHeader header;
+  if (end - begin < (int64_t) sizeof(header)) throw runtime_error("Truncated binary hypergraph file");
+  memcpy(&header, begin, sizeof(header));
+  if (memcmp(header.magic, mgbMagic, 4) != 0) throw runtime_error("Not a binary hypergraph file");
+  if (header.version != mgbVersion) throw runtime_error("Unsupported binary hypergraph version");
+  if (header.byteOrder != byteOrderMark) throw runtime_error("Binary hypergraph file written with a different byte order");
+  if (header.indexSize != sizeof(Index) || header.offsetSize != sizeof(Offset)) {
+    throw runtime_error("Binary hypergraph file written with a different index size");
+  }
+
+  // The header is checked before anything is allocated or read from the arrays
+  int64_t maxIndex = numeric_limits<Index>::max();
+  for (int64_t count : {header.nNodes, header.nHedges, header.nParts, header.nNodeWeights, header.nHedgeWeights, header.nPartWeights}) {
+    if (count < 0 || count > maxIndex) throw runtime_error("Invalid count in binary hypergraph file");
+  }
+  if (header.nPins < 0) throw runtime_error("Invalid count in binary hypergraph file");
+  if (header.nParts * header.nPartWeights > maxIndex) throw runtime_error("Invalid count in binary hypergraph file");
+  const int64_t expectedSize[mgbArrays] = {
+    header.nNodes + 1, header.nPins,
+    header.nHedges + 1, header.nPins,
+    header.nNodes * header.nNodeWeights, header.nHedges * header.nHedgeWeights,
+    header.nParts * header.nPartWeights
+  };
+  for (int i = 0; i < mgbArrays; ++i) {
+    if (header.arraySize[i] != expectedSize[i]) throw runtime_error("Inconsistent binary hypergraph file");
+  }
+
+  Hypergraph ret(header.nNodeWeights, header.nHedgeWeights, header.nPartWeights);
+  ret.nNodes_ = header.nNodes;
+  ret.nHedges_ = header.nHedges;
+  ret.nParts_ = header.nParts;
+  ret.nPins_ = header.nPins;
+  uint64_t checksum = 0;
+  readMgbArray(begin, end, header, 0, ret.nodeBegin_, checksum);
+  readMgbArray(begin, end, header, 1, ret.nodePins_, checksum);
+  readMgbArray(begin, end, header, 2, ret.hedgeBegin_, checksum);
+  readMgbArray(begin, end, header, 3, ret.hedgePins_, checksum);
+  readMgbArray(begin, end, header, 4, ret.nodeWeights_, checksum);
+  readMgbArray(begin, end, header, 5, ret.hedgeWeights_, checksum);
+  readMgbArray(begin, end, header, 6, ret.partData_, checksum);
+  if (checksum != header.checksum) throw runtime_error("Invalid checksum in binary hypergraph file");
+  // The checksum does not protect against a consistent but wrong file, and the cache loads files without other checks
+  ret.checkConsistency(ValidationLevel::Cheap);
+
+  // The pins of the nodes are stored: only the totals are recomputed
+  ret.finalizeNodeWeights();
+  ret.finalizeHedgeWeights();
+  ret.finalizePartWeights();
+  return ret;
+}
+
+void Hypergraph::writeMgb(ostream &s) const {
+  if (pinsCompressed_) {
+    // The file holds the plain arrays
+    Hypergraph plain = *this;
+    plain.decompressPins();
+    plain.writeMgb(s);
+    return;
   }
+  const char *arrays[mgbArrays] = {
+    (const char *) nodeBegin_.data(), (const char *) nodePins_.data(),
+    (const char *) hedgeBegin_.data(), (const char *) hedgePins_.data(),
+    (const char *) nodeWeights_.data(), (const char *) hedgeWeights_.data(),
+    (const char *) partData_.data()
+  };
+  int64_t arrayBytes[mgbArrays] = {
+    (int64_t) (nodeBegin_.size() * sizeof(Offset)), (int64_t) (nodePins_.size() * sizeof(Index)),
+    (int64_t) (hedgeBegin_.size() * sizeof(Offset)), (int64_t) (hedgePins_.size() * sizeof(Index)),
+    (int64_t) (nodeWeights_.size() * sizeof(Index)), (int64_t) (hedgeWeights_.size() * sizeof(Index)),
+    (int64_t) (partData_.size() * sizeof(Index))
+  };
+  int64_t arraySizes[mgbArrays] = {
+    (int64_t) nodeBegin_.size(), (int64_t) nodePins_.size(),
+    (int64_t) hedgeBegin_.size(), (int64_t) hedgePins_.size(),
+    (int64_t) nodeWeights_.size(), (int64_t) hedgeWeights_.size(),
+    (int64_t) partData_.size()
+  };
+  MgbHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, mgbMagic, 4);
+  header.version = mgbVersion;
+  header.byteOrder = byteOrderMark;
+  header.indexSize = sizeof(Index);
+  header.offsetSize = sizeof(Offset);
+  header.nNodes = nNodes_;
+  header.nHedges = nHedges_;
+  header.nParts = nParts_;
+  header.nPins = nPins_;
+  header.nNodeWeights = nNodeWeights_;
+  header.nHedgeWeights = nHedgeWeights_;
+  header.nPartWeights = nPartWeights_;
+  int64_t offset = sizeof(header);
+  for (int i = 0; i < mgbArrays; ++i) {
+    offset = (offset + mgbAlignment - 1) / mgbAlignment * mgbAlignment;
+    header.arrayOffset[i] = offset;
+    header.arraySize[i] = arraySizes[i];
+    header.checksum = binaryChecksum(header.checksum, arrays[i], arrayBytes[i]);
+    offset += arrayBytes[i];
+  }
+
+  s.write((const char *) &header, sizeof(header));
+  offset = sizeof(header);
+  const char padding[mgbAlignment] = {};
+  for (int i = 0; i < mgbArrays; ++i) {
+    s.write(padding, header.arrayOffset[i] - offset);
+    s.write(arrays[i], arrayBytes[i]);
+    offset = header.arrayOffset[i] + arrayBytes[i];
+  }
+  s.flush();
+  if (s.fail()) throw runtime_error("Unable to write the binary hypergraph");
 }
 
 Solution Solution::read(istream &s) {
@@ -299,10 +727,72 @@ Solution Solution::read(istream &s) {
 }
 
 void Solution::write(ostream &s) const {
+  TextWriter w(s);
   for (Index p : parts_) {
-    s << p << "\n";
+    w.write(p);
+    w.write('\n');
   }
-  s.flush();
+}
+
+Solution Solution::readBinary(const char *begin, const char *end) {
+  MsbHeader header;
+  if (end - begin < (int64_t) sizeof(header)) throw runtime_error("Truncated binary solution file");
+  memcpy(&header, begin, sizeof(header));
+  if (memcmp(header.magic, msbMagic, 4) != 0) throw runtime_error("Not a binary solution file");
+  if (header.version != msbVersion) throw runtime_error("Unsupported binary solution version");
+  if (header.byteOrder != byteOrderMark) throw runtime_error("Binary solution file written with a different byte order");
+  int64_t partBytes = header.partBytes;
+  if (partBytes != 1 && partBytes != 2 && partBytes != 4) throw runtime_error("Invalid binary solution file");
+  if (header.nNodes < 0 || header.nNodes > (int64_t) (end - begin - sizeof(header)) / partBytes) {
+    throw runtime_error("Truncated binary solution file");
+  }
+  const char *data = begin + sizeof(header);
+  if (binaryChecksum(0, data, header.nNodes * partBytes) != header.checksum) {
+    throw runtime_error("Invalid checksum in binary solution file");
+  }
+  Solution ret(header.nNodes, header.nParts);
+  for (Index node = 0; node < ret.nNodes(); ++node) {
+    if (partBytes == 1) {
+      ret.parts_[node] = (unsigned char) data[node];
+    }
+    else if (partBytes == 2) {
+      uint16_t part;
+      memcpy(&part, data + 2 * node, 2);
+      ret.parts_[node] = part;
+    }
+    else {
+      memcpy(&ret.parts_[node], data + 4 * node, 4);
+    }
+  }
+  return ret;
+}
+
+void Solution::writeBinary(ostream &s) const {
+  MsbHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, msbMagic, 4);
+  header.version = msbVersion;
+  header.byteOrder = byteOrderMark;
+  header.partBytes = nParts() <= (1 << 8) ? 1 : nParts() <= (1 << 16) ? 2 : 4;
+  header.nNodes = nNodes();
+  header.nParts = nParts();
+  vector<char> data(header.partBytes * nNodes());
+  for (Index node = 0; node < nNodes(); ++node) {
+    if (header.partBytes == 1) {
+      data[node] = (char) parts_[node];
+    }
+    else if (header.partBytes == 2) {
+      uint16_t part = parts_[node];
+      memcpy(&data[2 * node], &part, 2);
+    }
+    else {
+      memcpy(&data[4 * node], &parts_[node], 4);
+    }
+  }
+  header.checksum = binaryChecksum(0, data.data(), data.size());
+  s.write((const char *) &header, sizeof(header));
+  s.write(data.data(), data.size());
+  if (s.fail()) throw runtime_error("Unable to write the binary solution");
 }
 
 namespace {
@@ -319,16 +809,41 @@ bool isMinipartFilename(const string &name) {
   bool mgrGz = name.size() >= 7 && name.compare(name.size() - 7, 7, ".mgr.gz") == 0;
   return mgr || mgrGz;
 }
+bool isMgbFilename(const string &name) {
+  bool mgb = name.size() >= 4 && name.compare(name.size() - 4, 4, ".mgb") == 0;
+  bool mgbGz = name.size() >= 7 && name.compare(name.size() - 7, 7, ".mgb.gz") == 0;
+  return mgb || mgbGz;
+}
+bool isBinarySolutionFilename(const string &name) {
+  bool msb = name.size() >= 4 && name.compare(name.size() - 4, 4, ".msb") == 0;
+  bool msbGz = name.size() >= 7 && name.compare(name.size() - 7, 7, ".msb.gz") == 0;
+  return msb || msbGz;
+}
+void writeCompressed(const string &name, const function<void(ostream &)> &write) {
+  ofstream file(name, ios_base::out | ios_base::binary | ios_base::trunc);
+  if (file.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
+  // Compressed as it is written, so that the whole text is never in memory
+  GzipOutputBuffer buffer(file);
+  ostream s(&buffer);
+  write(s);
+  buffer.finish();
+  if (file.fail()) throw runtime_error("Unable to write the file \"" + name + "\"");
+}
 }
 
 Solution Solution::readFile(const string &name) {
+  TraceScope trace("Read solution");
+  if (isBinarySolutionFilename(name)) {
+    FileContents file(name);
+    if (isGzipFilename(name)) {
+      string contents = gzipDecompress(file.begin(), file.end());
+      return readBinary(contents.data(), contents.data() + contents.size());
+    }
+    return readBinary(file.begin(), file.end());
+  }
   if (isGzipFilename(name)) {
-    ifstream file(name, ios_base::in | ios_base::binary);
-    if (file.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
-    boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-    in.push(boost::iostreams::gzip_decompressor());
-    in.push(file);
-    std::istream inf(&in);
+    FileContents file(name);
+    istringstream inf(gzipDecompress(file.begin(), file.end()));
     return Solution::read(inf);
   }
   else {
@@ -339,61 +854,55 @@ Solution Solution::readFile(const string &name) {
 }
 
 void Solution::writeFile(const string &name) const {
+  TraceScope trace("Write solution");
+  bool binary = isBinarySolutionFilename(name);
   if (isGzipFilename(name)) {
-    boost::iostreams::gzip_params params;
-    params.level = 9;
-    ofstream file(name, ios_base::out | ios_base::binary | ios_base::trunc);
-    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
-    out.push(boost::iostreams::gzip_compressor(params));
-    out.push(file);
-    std::ostream outf(&out);
-    write(outf);
+    writeCompressed(name, [&](ostream &s) {
+      if (binary) writeBinary(s);
+      else write(s);
+    });
   }
   else {
-    ofstream f(name);
-    write(f);
+    ofstream f(name, ios_base::out | ios_base::binary | ios_base::trunc);
+    if (binary) writeBinary(f);
+    else write(f);
   }
 }
 
 Hypergraph Hypergraph::readFile(const string &name) {
+  TraceScope trace("Read hypergraph");
   if (isGzipFilename(name)) {
-    ifstream file(name, ios_base::in | ios_base::binary);
-    if (file.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
-    boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-    in.push(boost::iostreams::gzip_decompressor());
-    in.push(file);
-    std::istream inf(&in);
-    return readStream(name, inf);
+    FileContents file(name);
+    string contents = gzipDecompress(file.begin(), file.end());
+    return readBuffer(name, contents.data(), contents.data() + contents.size());
   }
   else {
-    ifstream file(name);
-    if (file.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
-    return readStream(name, file);
+    FileContents contents(name);
+    return readBuffer(name, contents.begin(), contents.end());
   }
 }
 
 void Hypergraph::writeFile(const string &name) const {
+  TraceScope trace("Write hypergraph");
   if (isGzipFilename(name)) {
-    boost::iostreams::gzip_params params;
-    params.level = 9;
-    ofstream file(name, ios_base::out | ios_base::binary | ios_base::trunc);
-    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
-    out.push(boost::iostreams::gzip_compressor(params));
-    out.push(file);
-    std::ostream outf(&out);
-    writeStream(name, outf);
+    writeCompressed(name, [&](ostream &s) {
+      writeStream(name, s);
+    });
   }
   else {
-    ofstream f(name);
+    ofstream f(name, ios_base::out | ios_base::binary | ios_base::trunc);
+    if (f.fail()) throw runtime_error("Unable to open the file \"" + name + "\"");
     writeStream(name, f);
   }
 }
 
-Hypergraph Hypergraph::readStream(const string &name, istream &s) {
+Hypergraph Hypergraph::readBuffer(const string &name, const char *begin, const char *end) {
   if (isHgrFilename(name))
-    return Hypergraph::readHgr(s);
+    return Hypergraph::readHgr(begin, end);
   else if (isMinipartFilename(name))
-    return Hypergraph::readMinipart(s);
+    return Hypergraph::readMinipart(begin, end);
+  else if (isMgbFilename(name))
+    return Hypergraph::readMgb(begin, end);
   else
     throw runtime_error("Unable to read file \"" + name + "\": unknown file extension");
 }
@@ -403,6 +912,8 @@ void Hypergraph::writeStream(const string &name, ostream &s) const {
     writeHgr(s);
   else if (isMinipartFilename(name))
     writeMinipart(s);
+  else if (isMgbFilename(name))
+    writeMgb(s);
   else
     throw runtime_error("Unable to write file \"" + name + "\": unknown file extension");
 }
@@ -0,0 +1,171 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "island.hh"
+#include "hypergraph.hh"
+#include "objective.hh"
+#include "event_log.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+void writeAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) throw runtime_error(string("Unable to send a solution: ") + strerror(errno));
+    data += n;
+    size -= n;
+  }
+}
+
+void readAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::read(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw runtime_error(string("Unable to receive a solution: ") + strerror(errno));
+    if (n == 0) throw runtime_error("Island disconnected");
+    data += n;
+    size -= n;
+  }
+}
+} // End anonymous namespace
+
+SocketTransport::~SocketTransport() {
+  ::close(fd_);
+}
+
+void SocketTransport::send(IslandMessageType type, const Solution &solution) {
+  // Header with the type and the number of nodes, followed by the parts
+  vector<Index> message;
+  message.reserve(solution.nNodes() + 2);
+  message.push_back((Index) type);
+  message.push_back(solution.nNodes());
+  for (Index node = 0; node < solution.nNodes(); ++node) {
+    message.push_back(solution[node]);
+  }
+  writeAll(fd_, reinterpret_cast<const char*>(message.data()), message.size() * sizeof(Index));
+}
+
+IslandMessageType SocketTransport::receive(Solution &solution) {
+  Index header[2];
+  readAll(fd_, reinterpret_cast<char*>(header), sizeof(header));
+  if (header[0] < 0 || header[0] > (Index) IslandMessageType::Final) throw runtime_error("Invalid island message");
+  if (header[1] != solution.nNodes()) throw runtime_error("Island message with the wrong number of nodes");
+  vector<Index> parts(header[1]);
+  readAll(fd_, reinterpret_cast<char*>(parts.data()), parts.size() * sizeof(Index));
+  for (Index node = 0; node < solution.nNodes(); ++node) {
+    if (parts[node] < 0 || parts[node] >= solution.nParts()) throw runtime_error("Island message with an invalid solution");
+    solution[node] = parts[node];
+  }
+  return (IslandMessageType) header[0];
+}
+
+Solution IslandMigration::exchange(const Solution &elite) {
+  transport_.send(IslandMessageType::Elite, elite);
+  Solution migrant(elite.nNodes(), elite.nParts());
+  if (transport_.receive(migrant) != IslandMessageType::Migrant) throw runtime_error("Unexpected island message");
+  return migrant;
+}
+
+IslandCoordinator::IslandCoordinator(Index nIslands, const function<Solution(Index, IslandMigration&)> &worker, Index migrationInterval) {
+  if (nIslands < 2) throw runtime_error("The island model requires at least two islands");
+  // Avoid duplicated output in the workers
+  cout.flush();
+  cerr.flush();
+  flushEventLog();
+  for (Index island = 0; island < nIslands; ++island) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      throw runtime_error(string("Unable to create an island socket: ") + strerror(errno));
+    }
+    int pid = fork();
+    if (pid < 0) {
+      throw runtime_error(string("Unable to start an island: ") + strerror(errno));
+    }
+    if (pid == 0) {
+      // Worker process
+      transports_.clear();
+      ::close(fds[0]);
+      int status = 0;
+      try {
+        SocketTransport transport(fds[1]);
+        IslandMigration migration(transport, migrationInterval);
+        Solution solution = worker(island, migration);
+        transport.send(IslandMessageType::Final, solution);
+      } catch (exception &e) {
+        cerr << "Island " << island << ": " << e.what() << endl;
+        status = 1;
+      }
+      cout.flush();
+      _exit(status);
+    }
+    ::close(fds[1]);
+    transports_.emplace_back(new SocketTransport(fds[0]));
+    pids_.push_back(pid);
+  }
+}
+
+IslandCoordinator::~IslandCoordinator() {
+  transports_.clear();
+  for (int pid : pids_) {
+    waitpid(pid, nullptr, 0);
+  }
+}
+
+Solution IslandCoordinator::run(const Hypergraph &hypergraph, const Objective &objective, int verbosity) {
+  Index nIslands = transports_.size();
+  vector<Solution> latest(nIslands, Solution(hypergraph.nNodes(), hypergraph.nParts()));
+  vector<bool> active(nIslands, true);
+  Solution best(hypergraph.nNodes(), hypergraph.nParts());
+  vector<int64_t> bestObj;
+
+  for (Index round = 0; ; ++round) {
+    vector<bool> waiting(nIslands, false);
+    bool anyWaiting = false;
+    for (Index island = 0; island < nIslands; ++island) {
+      if (!active[island]) continue;
+      IslandMessageType type = transports_[island]->receive(latest[island]);
+      if (type == IslandMessageType::Migrant) throw runtime_error("Unexpected island message");
+      waiting[island] = type == IslandMessageType::Elite;
+      active[island] = type == IslandMessageType::Elite;
+      anyWaiting = anyWaiting || waiting[island];
+      vector<int64_t> obj = objective.eval(hypergraph, latest[island]);
+      if (bestObj.empty() || obj < bestObj) {
+        best = latest[island];
+        bestObj = obj;
+      }
+    }
+    if (!anyWaiting) break;
+
+    // Ring migration: each island receives the latest solution of the previous one
+    for (Index island = 0; island < nIslands; ++island) {
+      if (!waiting[island]) continue;
+      transports_[island]->send(IslandMessageType::Migrant, latest[(island + nIslands - 1) % nIslands]);
+    }
+    if (eventLogEnabled()) {
+      Event("migration").add("round", round + 1).add("objective", bestObj).emit();
+    }
+    if (verbosity >= 2) {
+      cout << "Migration round #" << round + 1 << ": ";
+      for (size_t i = 0; i < bestObj.size(); ++i) {
+        if (i > 0) cout << ", ";
+        cout << bestObj[i];
+      }
+      cout << endl;
+    }
+  }
+  return best;
+}
+
+} // End namespace minipart
+
@@ -2,21 +2,27 @@
 #include "local_search_optimizer.hh"
 #include "move.hh"
 #include "partitioning_params.hh"
+#include "trace.hh"
 
 using namespace std;
 
 namespace minipart {
 
-LocalSearchOptimizer::LocalSearchOptimizer(IncrementalObjective &inc, const PartitioningParams &params, mt19937 &rgen)
+LocalSearchOptimizer::LocalSearchOptimizer(IncrementalObjective &inc, const PartitioningParams &params, mt19937 &rgen, const StopCondition &stop)
 : inc_(inc)
 , params_(params)
-, rgen_(rgen) {
+, rgen_(rgen)
+, stop_(stop) {
 }
 
 void LocalSearchOptimizer::run() {
   assert (inc_.nNodes() > 0);
+  TraceScope trace("Local search", "nodes", inc_.nNodes());
   init();
-  while (totalBudget() > 0) {
+  // The stop condition is only checked periodically, as moves are cheap
+  const int checkInterval = 256;
+  for (int64_t i = 0; totalBudget() > 0; ++i) {
+    if (i % checkInterval == 0 && stop_.stop()) break;
     doMove();
   }
 }
@@ -1,13 +1,21 @@
 // Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
 
 #include "hypergraph.hh"
+#include "hypergraph_cache.hh"
 #include "partitioning_params.hh"
 #include "blackbox_optimizer.hh"
-#include "objective.hh"
+#include "parallel.hh"
+#include "gzip.hh"
+#include "stop_condition.hh"
+#include "event_log.hh"
+#include "profiler.hh"
+#include "trace.hh"
 #include "config.hh"
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <chrono>
 #include <boost/program_options.hpp>
 
 using namespace std;
@@ -18,13 +26,13 @@ po::options_description getBaseOptions() {
   po::options_description desc("Options");
 
   desc.add_options()("hypergraph,i", po::value<string>(),
-                     "Input file name (.hgr or .mgr)");
+                     "Input file name (.hgr, .mgr or .mgb)");
 
   desc.add_options()("solution,o", po::value<string>(),
-                     "Solution file (.sol)");
+                     "Solution file (.sol, or .msb for the binary format)");
 
   desc.add_options()("initial,f", po::value<string>(),
-                     "Initial solution file (.sol)");
+                     "Initial solution file (.sol or .msb)");
 
   desc.add_options()("blocks,k", po::value<Index>()->default_value(2),
                      "Number of blocks");
@@ -41,6 +49,21 @@ po::options_description getBaseOptions() {
   desc.add_options()("seed,s", po::value<size_t>()->default_value(0),
                      "Random seed");
 
+  desc.add_options()("cache", po::value<string>(),
+                     "Directory to cache the preprocessed hypergraphs");
+
+  desc.add_options()("cache-size", po::value<double>()->default_value(1024.0),
+                     "Size limit of the cache directory (MB)");
+
+  desc.add_options()("gzip-level", po::value<Index>()->default_value(6),
+                     "Compression level of the .gz output files");
+
+  desc.add_options()("reorder",
+                     "Renumber nodes and edges for memory locality after reading");
+
+  desc.add_options()("compress-pins",
+                     "Store the pins delta- and varint-encoded: less memory, slower traversals");
+
   desc.add_options()("help,h", "Print this help");
 
   return desc;
@@ -55,6 +78,27 @@ po::options_description getBlackboxOptions() {
   desc.add_options()("v-cycles", po::value<Index>()->default_value(1),
                      "Number of V-cycles");
 
+  desc.add_options()("schedule", po::value<SearchSchedule>()->default_value(SearchSchedule::VCycle),
+                     "Search schedule: vcycle or memetic");
+
+  desc.add_options()("generations", po::value<Index>()->default_value(32),
+                     "Number of recombinations for the memetic schedule");
+
+  desc.add_options()("prune-margin", po::value<double>()->default_value(0.0),
+                     "Drop pool solutions trailing the best by this relative margin on any objective component (0 to disable)");
+
+  desc.add_options()("prune-realloc", po::value<double>()->default_value(0.0),
+                     "Fraction of the budget of dropped solutions given to the others");
+
+  desc.add_options()("initial-placement", po::value<InitialPlacement>()->default_value(InitialPlacement::Random),
+                     "Initial placement: random or multilevel");
+
+  desc.add_options()("recursive-bisection",
+                     "Partition by recursive bisection (for large numbers of blocks)");
+
+  desc.add_options()("rb-refine",
+                     "Refine the recursive bisection with a k-way local search");
+
   desc.add_options()("min-c-factor", po::value<double>()->default_value(1.2),
                      "Minimum coarsening factor");
 
@@ -67,6 +111,33 @@ po::options_description getBlackboxOptions() {
   desc.add_options()("move-ratio", po::value<double>()->default_value(8.0),
                      "Number of moves per vertex");
 
+  desc.add_options()("time-limit,t", po::value<double>()->default_value(0.0),
+                     "Time limit in seconds (0 for none)");
+
+  desc.add_options()("checkpoint", po::value<string>()->default_value(""),
+                     "Checkpoint file, written after each cycle");
+
+  desc.add_options()("resume", "Resume the search from the checkpoint file");
+
+  desc.add_options()("islands", po::value<Index>()->default_value(1),
+                     "Number of worker processes exchanging solutions, sharing the threads");
+
+  desc.add_options()("migration-interval", po::value<Index>()->default_value(1),
+                     "Number of cycles between two exchanges of solutions");
+
+#ifdef MINIPART_PROFILING
+  desc.add_options()("perf-counters", "Read hardware performance counters for each phase");
+#endif
+
+  desc.add_options()("trace", po::value<string>(),
+                     "Write a timeline of the run in the Chrome trace format");
+
+  desc.add_options()("events", po::value<string>(),
+                     "Write progress events as JSON lines to a file, or fd:N");
+
+  desc.add_options()("threads,j", po::value<Index>()->default_value(0),
+                     "Number of threads (0 for all cores)");
+
   return desc;
 }
 
@@ -75,8 +146,11 @@ po::options_description getHiddenOptions() {
 
   desc.add_options()("no-solve", "Skip the solving phase");
 
+  desc.add_options()("validation", po::value<ValidationLevel>()->default_value(ValidationLevel::Cheap),
+                     "Consistency checks: off, cheap or full");
+
   desc.add_options()("export", po::value<string>(),
-                     "Write the hypergraph (.hgr or .mgr)");
+                     "Write the hypergraph (.hgr, .mgr or .mgb)");
 
   desc.add_options()("version", "Show the program version");
 
@@ -129,10 +203,73 @@ po::variables_map parseArguments(int argc, char **argv) {
   return vm;
 }
 
-Hypergraph readHypergraph(const po::variables_map &vm) {
-  Hypergraph hg = Hypergraph::readFile(vm["hypergraph"].as<string>());
-  hg.checkConsistency();
+Hypergraph preprocessHypergraph(const string &name, ValidationLevel validation) {
+  Hypergraph hg = Hypergraph::readFile(name);
+  hg.checkConsistency(validation);
   hg.mergeParallelHedges();
+  return hg;
+}
+
+double pinTraversalSeconds(const Hypergraph &hg) {
+  // Visit the pins from both sides, as the optimization does
+  auto start = chrono::steady_clock::now();
+  uint64_t checksum = 0;
+  hg.visitPins([&](auto layout) {
+    for (Index hedge = 0; hedge < hg.nHedges(); ++hedge) {
+      for (Index node : hg.hedgeNodes(hedge, layout)) checksum += node;
+    }
+    for (Index node = 0; node < hg.nNodes(); ++node) {
+      for (Index hedge : hg.nodeHedges(node, layout)) checksum += hedge;
+    }
+  });
+  // Keep the traversal from being optimized away
+  volatile uint64_t sink = checksum;
+  (void) sink;
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void compressPins(const po::variables_map &vm, Hypergraph &hg) {
+  if (!vm.count("compress-pins")) return;
+  int64_t plainBytes = hg.pinBytes();
+  double plainSeconds = pinTraversalSeconds(hg);
+  hg.compressPins();
+  int64_t compressedBytes = hg.pinBytes();
+  double compressedSeconds = pinTraversalSeconds(hg);
+  double nsPerPin = 1.0e9 / max((Offset) 1, 2 * hg.nPins());
+  if (vm["verbosity"].as<Index>() >= 1) {
+    cout << "Pin storage: " << plainBytes / 1.0e6 << "MB plain, " << compressedBytes / 1.0e6 << "MB compressed";
+    cout << " (" << 100.0 * (plainBytes - compressedBytes) / max((int64_t) 1, plainBytes) << "% saved)" << endl;
+    cout << "Pin traversal: " << plainSeconds * nsPerPin << "ns per pin plain, " << compressedSeconds * nsPerPin << "ns compressed" << endl;
+    cout << endl;
+  }
+  if (eventLogEnabled()) {
+    Event("pin_compression")
+      .add("plain_bytes", plainBytes)
+      .add("compressed_bytes", compressedBytes)
+      .add("plain_ns_per_pin", plainSeconds * nsPerPin)
+      .add("compressed_ns_per_pin", compressedSeconds * nsPerPin)
+      .emit();
+  }
+}
+
+Hypergraph readHypergraph(const po::variables_map &vm) {
+  MINIPART_PROFILE_SCOPE("read");
+  string name = vm["hypergraph"].as<string>();
+  ValidationLevel validation = vm["validation"].as<ValidationLevel>();
+  Hypergraph hg;
+  if (vm.count("cache")) {
+    HypergraphCache cache(vm["cache"].as<string>(), vm["cache-size"].as<double>() * 1.0e6);
+    stringstream options;
+    options << "validation " << validation;
+    string key = cache.key(name, options.str());
+    if (!cache.read(key, hg)) {
+      hg = preprocessHypergraph(name, validation);
+      cache.write(key, hg);
+    }
+  }
+  else {
+    hg = preprocessHypergraph(name, validation);
+  }
   hg.setupBlocks(
     vm["blocks"].as<Index>(),
     vm["imbalance"].as<double>() / 100.0
@@ -140,17 +277,43 @@ Hypergraph readHypergraph(const po::variables_map &vm) {
   return hg;
 }
 
+Solution reorderHypergraph(const po::variables_map &vm, Hypergraph &hg) {
+  if (!vm.count("reorder")) {
+    Solution identity(hg.nNodes(), hg.nNodes());
+    for (Index node = 0; node < hg.nNodes(); ++node) identity[node] = node;
+    return identity;
+  }
+  MINIPART_PROFILE_SCOPE("reorder");
+  Solution ordering = hg.computeLocalityOrdering();
+  hg = hg.reorder(ordering);
+  hg.checkConsistency(vm["validation"].as<ValidationLevel>());
+  return ordering;
+}
+
 PartitioningParams readParams(const po::variables_map &vm, const Hypergraph &hg) {
   return PartitioningParams {
     .verbosity = vm["verbosity"].as<Index>(),
     .seed = vm["seed"].as<size_t>(),
     .objective = vm["objective"].as<ObjectiveType>(),
+    .validation = vm["validation"].as<ValidationLevel>(),
     .nSolutions = vm["pool-size"].as<Index>(),
     .nCycles = vm["v-cycles"].as<Index>(),
+    .initialPlacement = vm["initial-placement"].as<InitialPlacement>(),
+    .schedule = vm["schedule"].as<SearchSchedule>(),
+    .nGenerations = vm["generations"].as<Index>(),
+    .pruningMargin = vm["prune-margin"].as<double>(),
+    .pruningReallocation = vm["prune-realloc"].as<double>(),
+    .recursiveBisection = vm.count("recursive-bisection") > 0,
+    .recursiveBisectionRefinement = vm.count("rb-refine") > 0,
     .minCoarseningFactor = vm["min-c-factor"].as<double>(),
     .maxCoarseningFactor = vm["max-c-factor"].as<double>(),
     .minCoarseningNodes = vm["min-c-nodes"].as<Index>(),
     .movesPerElement = vm["move-ratio"].as<double>(),
+    .timeLimit = vm["time-limit"].as<double>(),
+    .checkpointFile = vm["checkpoint"].as<string>(),
+    .resume = vm.count("resume") > 0,
+    .nIslands = vm["islands"].as<Index>(),
+    .migrationInterval = vm["migration-interval"].as<Index>(),
     .nNodes = hg.nNodes(),
     .nHedges = hg.nHedges(),
     .nPins = hg.nPins(),
@@ -163,7 +326,7 @@ void writeHypergraph(const po::variables_map &vm, const Hypergraph &hg) {
   hg.writeFile(vm["export"].as<string>());
 }
 
-vector<Solution> readInitialSolutions(const po::variables_map &vm, const Hypergraph &hg) {
+vector<Solution> readInitialSolutions(const po::variables_map &vm, const Hypergraph &hg, const Solution &ordering) {
   vector<Solution> solutions;
   if (vm.count("initial")) {
     Solution sol = Solution::readFile(vm["initial"].as<string>());
@@ -176,12 +339,24 @@ vector<Solution> readInitialSolutions(const po::variables_map &vm, const Hypergr
       exit(1);
     }
     sol.resizeParts(hg.nParts());
+    if (vm.count("reorder")) {
+      if (sol.nNodes() != hg.nNodes()) {
+        cerr << "The initial solution has " << sol.nNodes() << " nodes but the hypergraph has " << hg.nNodes() << endl;
+        exit(1);
+      }
+      sol = sol.coarsen(ordering);
+    }
   }
   return solutions;
 }
 
-void writeFinalSolution(const po::variables_map &vm, const Solution &solution) {
-  if (vm.count("solution")) {
+void writeFinalSolution(const po::variables_map &vm, const Solution &solution, const Solution &ordering) {
+  if (!vm.count("solution")) return;
+  if (vm.count("reorder")) {
+    // Back to the original numbering
+    solution.uncoarsen(ordering).writeFile(vm["solution"].as<string>());
+  }
+  else {
     solution.writeFile(vm["solution"].as<string>());
   }
 }
@@ -218,9 +393,9 @@ void reportMainMetrics(const PartitioningParams &params, const Hypergraph &hg, c
 }
 
 void reportPartitionUsage(const PartitioningParams &params, const Hypergraph &hg, const Solution &sol) {
-  std::vector<Index> usage  = hg.metricsPartitionUsage(sol);
+  std::vector<int64_t> usage  = hg.metricsPartitionUsage(sol);
   if (params.isRatioObj()) {
-    Index totNodeWeight = hg.totalNodeWeight();
+    int64_t totNodeWeight = hg.totalNodeWeight();
     cout << "Partition usage:" << endl;
     for (Index p = 0; p < hg.nParts(); ++p) {
       cout << "\tPart#" << p << "  \t";
@@ -246,7 +421,7 @@ void reportPartitionUsage(const PartitioningParams &params, const Hypergraph &hg
 void reportPartitionDegree(const PartitioningParams &params, const Hypergraph &hg, const Solution &sol) {
   if (hg.nParts() <= 2) return;
 
-  std::vector<Index> degree = hg.metricsPartitionDegree(sol);
+  std::vector<int64_t> degree = hg.metricsPartitionDegree(sol);
   cout << "Partition degrees:" << endl;
   for (Index p = 0; p < hg.nParts(); ++p) {
     cout << "\tPart#" << p << "  \t";
@@ -269,31 +444,34 @@ void report(const PartitioningParams &params, const Hypergraph &hg, const Soluti
   reportPartitionDegree(params, hg, sol);
 }
 
-unique_ptr<Objective> readObjective(const po::variables_map &vm) {
-  switch (vm["objective"].as<ObjectiveType>()) {
-    case ObjectiveType::Cut:
-      return make_unique<CutObjective>();
-    case ObjectiveType::Soed:
-      return make_unique<SoedObjective>();
-    case ObjectiveType::MaxDegree:
-      return make_unique<MaxDegreeObjective>();
-    case ObjectiveType::DaisyChainDistance:
-      return make_unique<DaisyChainDistanceObjective>();
-    case ObjectiveType::DaisyChainMaxDegree:
-      return make_unique<DaisyChainMaxDegreeObjective>();
-    case ObjectiveType::RatioCut:
-      return make_unique<RatioCutObjective>();
-    case ObjectiveType::RatioSoed:
-      return make_unique<RatioSoedObjective>();
-    case ObjectiveType::RatioMaxDegree:
-      return make_unique<RatioMaxDegreeObjective>();
-    default:
-      cout << "Objective type is not supported." << endl;
-      exit(1);
+void reportEvents(const char *type, const PartitioningParams &params, const Hypergraph &hg, const Solution &sol) {
+  if (!eventLogEnabled()) return;
+  Event event(type);
+  event.add("cut", hg.metricsCut(sol));
+  if (hg.nParts() > 2) {
+    event.add("connectivity", hg.metricsConnectivity(sol));
+    event.add("max_degree", hg.metricsMaxDegree(sol));
+  }
+  if (params.isDaisyChainObj() && hg.nParts() > 2) {
+    event.add("daisy_chain_distance", hg.metricsDaisyChainDistance(sol));
+    event.add("daisy_chain_max_degree", hg.metricsDaisyChainMaxDegree(sol));
+  }
+  if (params.isRatioObj()) {
+    event.add("ratio_cut", hg.metricsRatioCut(sol));
+    if (hg.nParts() > 2) {
+      event.add("ratio_connectivity", hg.metricsRatioConnectivity(sol));
+      event.add("ratio_max_degree", hg.metricsRatioMaxDegree(sol));
+    }
+    event.add("ratio_penalty", hg.metricsRatioPenalty(sol) - 1.0);
   }
+  event.add("usage", hg.metricsPartitionUsage(sol));
+  event.emit();
 }
 
 void initialReport(const Hypergraph &hg, const PartitioningParams &params, const vector<Solution> &initialSolutions) {
+  for (const Solution &sol : initialSolutions) {
+    reportEvents("initial", params, hg, sol);
+  }
   if (params.verbosity >= 1) {
     report(params, hg);
     if (initialSolutions.size() > 0) {
@@ -306,6 +484,9 @@ void initialReport(const Hypergraph &hg, const PartitioningParams &params, const
 }
 
 void finalReport(const Hypergraph &hg, const PartitioningParams &params, const vector<Solution> &finalSolutions) {
+  for (const Solution &sol : finalSolutions) {
+    reportEvents("final", params, hg, sol);
+  }
   if (params.verbosity >= 1) {
     for (const Solution &sol : finalSolutions) {
       report(params, hg, sol);
@@ -315,19 +496,46 @@ void finalReport(const Hypergraph &hg, const PartitioningParams &params, const v
 
 int main(int argc, char **argv) {
   po::variables_map vm = parseArguments(argc, argv);
+  setNThreads(vm["threads"].as<Index>());
+  setGzipLevel(vm["gzip-level"].as<Index>());
+  StopCondition::installSignalHandlers();
+  if (vm.count("events")) openEventLog(vm["events"].as<string>());
+  if (vm.count("trace")) openTrace(vm["trace"].as<string>());
+#ifdef MINIPART_PROFILING
+  if (vm.count("perf-counters")) enablePerfCounters();
+#endif
 
   Hypergraph hg = readHypergraph(vm);
+  Solution ordering = reorderHypergraph(vm, hg);
+  compressPins(vm, hg);
   PartitioningParams params = readParams(vm, hg);
-  unique_ptr<Objective> objectivePtr = readObjective(vm);
-  vector<Solution> initialSolutions = readInitialSolutions(vm, hg);
+  if (eventLogEnabled()) {
+    Event("start")
+      .add("nodes", hg.nNodes())
+      .add("hedges", hg.nHedges())
+      .add("pins", hg.nPins())
+      .add("parts", hg.nParts())
+      .emit();
+  }
+  vector<Solution> initialSolutions = readInitialSolutions(vm, hg, ordering);
 
   initialReport(hg, params, initialSolutions);
   writeHypergraph(vm, hg);
-  if (vm.count("no-solve") || vm.count("export"))  return 0;
+  if (vm.count("no-solve") || vm.count("export")) {
+    closeEventLog();
+    closeTrace();
+    return 0;
+  }
 
-  Solution solution = BlackboxOptimizer::run(hg, params, *objectivePtr, initialSolutions);
+  // The command line is single-threaded here, so the island workers can be forked
+  Solution solution = partitionIslands(hg, params, initialSolutions);
   finalReport(hg, params, {solution});
-  writeFinalSolution(vm, solution);
+  writeFinalSolution(vm, solution, ordering);
+  closeEventLog();
+  closeTrace();
+#ifdef MINIPART_PROFILING
+  printProfile(cout);
+#endif
   return 0;
 }
 
@@ -120,16 +120,23 @@ void EdgeMoveRandomBlock::run(IncrementalObjective &inc, mt19937 &rgen) {
   uniform_int_distribution<Index> partDist(0, inc.nParts()-1);
   Index hedge = edgeDist(rgen);
   Index dst = partDist(rgen);
-  if (inc.hypergraph().hedgeNodes(hedge).size() > edgeDegreeCutoff_) {
+  // The pins are listed before moving them, in the layout of the hypergraph
+  bool tooLarge = inc.hypergraph().visitPins([&](auto layout) {
+    auto pins = inc.hypergraph().hedgeNodes(hedge, layout);
+    if (pins.size() > edgeDegreeCutoff_) return true;
+    for (Index node : pins) {
+      initialStatus_.emplace_back(node, inc.solution()[node]);
+    }
+    return false;
+  });
+  if (tooLarge) {
     --this->budget_;
     return;
   }
 
   vector<int64_t> before = inc.objectives();
-  for (Index node : inc.hypergraph().hedgeNodes(hedge)) {
-    Index src = inc.solution()[node];
-    inc.move(node, dst);
-    initialStatus_.emplace_back(node, src);
+  for (pair<Index, Index> status : initialStatus_) {
+    inc.move(status.first, dst);
   }
   vector<int64_t> after = inc.objectives();
   if (before < after) {
@@ -137,7 +144,7 @@ void EdgeMoveRandomBlock::run(IncrementalObjective &inc, mt19937 &rgen) {
       inc.move(status.first, status.second);
     }
   }
-  this->budget_ -= inc.hypergraph().hedgeNodes(hedge).size();
+  this->budget_ -= initialStatus_.size();
 }
 
 void VertexAbsorptionPass::run(IncrementalObjective &inc, mt19937 &rgen) {
@@ -163,15 +170,17 @@ void VertexAbsorptionPass::run(IncrementalObjective &inc, mt19937 &rgen) {
       inc.move(node, src);
     }
     else {
-      if (inc.hypergraph().nodeHedges(node).size() <= nodeDegreeCutoff_) {
-        for (Index hEdge : inc.hypergraph().nodeHedges(node)) {
-          if (inc.hypergraph().hedgeNodes(hEdge).size() <= edgeDegreeCutoff_) {
-            for (Index neighbour : inc.hypergraph().hedgeNodes(hEdge)) {
-              candidates_.push_back(neighbour);
+      inc.hypergraph().visitPins([&](auto layout) {
+        if (inc.hypergraph().nodeHedges(node, layout).size() <= nodeDegreeCutoff_) {
+          for (Index hEdge : inc.hypergraph().nodeHedges(node, layout)) {
+            if (inc.hypergraph().hedgeNodes(hEdge, layout).size() <= edgeDegreeCutoff_) {
+              for (Index neighbour : inc.hypergraph().hedgeNodes(hEdge, layout)) {
+                candidates_.push_back(neighbour);
+              }
             }
           }
         }
-      }
+      });
     }
   }
 }
@@ -5,41 +5,65 @@
 
 #include <cassert>
 #include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
 namespace minipart {
 
-unique_ptr<IncrementalObjective> CutObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalCut>(h, s);
+unique_ptr<Objective> Objective::create(ObjectiveType type) {
+  switch (type) {
+    case ObjectiveType::Cut:
+      return make_unique<CutObjective>();
+    case ObjectiveType::Soed:
+      return make_unique<SoedObjective>();
+    case ObjectiveType::MaxDegree:
+      return make_unique<MaxDegreeObjective>();
+    case ObjectiveType::DaisyChainDistance:
+      return make_unique<DaisyChainDistanceObjective>();
+    case ObjectiveType::DaisyChainMaxDegree:
+      return make_unique<DaisyChainMaxDegreeObjective>();
+    case ObjectiveType::RatioCut:
+      return make_unique<RatioCutObjective>();
+    case ObjectiveType::RatioSoed:
+      return make_unique<RatioSoedObjective>();
+    case ObjectiveType::RatioMaxDegree:
+      return make_unique<RatioMaxDegreeObjective>();
+    default:
+      throw runtime_error("Objective type is not supported");
+  }
 }
 
-unique_ptr<IncrementalObjective> SoedObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalSoed>(h, s);
+unique_ptr<IncrementalObjective> CutObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalCut>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> MaxDegreeObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalMaxDegree>(h, s);
+unique_ptr<IncrementalObjective> SoedObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalSoed>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> DaisyChainDistanceObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalDaisyChainDistance>(h, s);
+unique_ptr<IncrementalObjective> MaxDegreeObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalMaxDegree>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> DaisyChainMaxDegreeObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalDaisyChainMaxDegree>(h, s);
+unique_ptr<IncrementalObjective> DaisyChainDistanceObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalDaisyChainDistance>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> RatioCutObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalRatioCut>(h, s);
+unique_ptr<IncrementalObjective> DaisyChainMaxDegreeObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalDaisyChainMaxDegree>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> RatioSoedObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalRatioSoed>(h, s);
+unique_ptr<IncrementalObjective> RatioCutObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalRatioCut>(h, s, pool);
 }
 
-unique_ptr<IncrementalObjective> RatioMaxDegreeObjective::incremental(const Hypergraph &h, Solution &s) const {
-  return make_unique<IncrementalRatioMaxDegree>(h, s);
+unique_ptr<IncrementalObjective> RatioSoedObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalRatioSoed>(h, s, pool);
+}
+
+unique_ptr<IncrementalObjective> RatioMaxDegreeObjective::incremental(const Hypergraph &h, Solution &s, BufferPool *pool) const {
+  return make_unique<IncrementalRatioMaxDegree>(h, s, pool);
 }
 
 vector<int64_t> CutObjective::eval(const Hypergraph &h, Solution &s) const {
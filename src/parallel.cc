@@ -0,0 +1,90 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "parallel.hh"
+#include "trace.hh"
+
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <exception>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+Index requestedThreads = 0;
+// Per-thread setting, passed on to the workers; 0 if unset
+thread_local Index scopedThreads = 0;
+// Nested parallel calls are run sequentially to avoid oversubscription
+thread_local bool inWorker = false;
+}
+
+void setNThreads(Index n) {
+  if (n < 0) throw runtime_error("The number of threads must be non-negative");
+  requestedThreads = n;
+}
+
+ThreadCountScope::ThreadCountScope(Index n) {
+  if (n < 0) throw runtime_error("The number of threads must be non-negative");
+  previous_ = scopedThreads;
+  if (n > 0) scopedThreads = n;
+}
+
+ThreadCountScope::~ThreadCountScope() {
+  scopedThreads = previous_;
+}
+
+Index nThreads() {
+  if (scopedThreads > 0) return scopedThreads;
+  if (requestedThreads > 0) return requestedThreads;
+  Index hw = thread::hardware_concurrency();
+  return hw > 0 ? hw : 1;
+}
+
+Index nChunks(Index n, Index grainSize) {
+  Index maxChunks = (n + grainSize - 1) / grainSize;
+  return max((Index) 1, min(nThreads(), maxChunks));
+}
+
+void parallelChunks(Index n, Index nChunks, const function<void(Index, Index, Index)> &f) {
+  if (inWorker) {
+    for (Index c = 0; c < nChunks; ++c) {
+      f(c, chunkBegin(n, nChunks, c), chunkBegin(n, nChunks, c + 1));
+    }
+    return;
+  }
+  if (nChunks <= 1) {
+    f(0, 0, n);
+    return;
+  }
+  // Exceptions are rethrown in the calling thread, the first chunk taking precedence
+  vector<exception_ptr> errors(nChunks);
+  Index callerThreads = scopedThreads;
+  auto run = [&](Index c) {
+    inWorker = true;
+    ThreadCountScope threads(callerThreads);
+    TraceScope trace("Parallel chunk", "chunk", c);
+    try {
+      f(c, chunkBegin(n, nChunks, c), chunkBegin(n, nChunks, c + 1));
+    } catch (...) {
+      errors[c] = current_exception();
+    }
+    inWorker = false;
+  };
+  vector<thread> threads;
+  threads.reserve(nChunks - 1);
+  for (Index c = 1; c < nChunks; ++c) {
+    threads.emplace_back(run, c);
+  }
+  run(0);
+  for (thread &t : threads) {
+    t.join();
+  }
+  for (const exception_ptr &e : errors) {
+    if (e) rethrow_exception(e);
+  }
+}
+
+} // End namespace minipart
+
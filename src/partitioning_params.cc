@@ -62,6 +62,83 @@ std::ostream &operator<<(std::ostream &os, const ObjectiveType &obj) {
   return os;
 }
 
+std::istream &operator>>(std::istream &is, InitialPlacement &placement) {
+  std::string token;
+  is >> token;
+  if (token == "random")
+    placement = InitialPlacement::Random;
+  else if (token == "multilevel")
+    placement = InitialPlacement::Multilevel;
+  else
+    is.setstate(std::ios_base::failbit);
+  return is;
+}
+
+std::ostream &operator<<(std::ostream &os, const InitialPlacement &placement) {
+  switch (placement) {
+    case InitialPlacement::Random:
+      os << "random";
+      break;
+    case InitialPlacement::Multilevel:
+      os << "multilevel";
+      break;
+  }
+  return os;
+}
+
+std::istream &operator>>(std::istream &is, SearchSchedule &schedule) {
+  std::string token;
+  is >> token;
+  if (token == "vcycle" || token == "v-cycle")
+    schedule = SearchSchedule::VCycle;
+  else if (token == "memetic")
+    schedule = SearchSchedule::Memetic;
+  else
+    is.setstate(std::ios_base::failbit);
+  return is;
+}
+
+std::ostream &operator<<(std::ostream &os, const SearchSchedule &schedule) {
+  switch (schedule) {
+    case SearchSchedule::VCycle:
+      os << "vcycle";
+      break;
+    case SearchSchedule::Memetic:
+      os << "memetic";
+      break;
+  }
+  return os;
+}
+
+std::istream &operator>>(std::istream &is, ValidationLevel &level) {
+  std::string token;
+  is >> token;
+  if (token == "off")
+    level = ValidationLevel::Off;
+  else if (token == "cheap")
+    level = ValidationLevel::Cheap;
+  else if (token == "full")
+    level = ValidationLevel::Full;
+  else
+    is.setstate(std::ios_base::failbit);
+  return is;
+}
+
+std::ostream &operator<<(std::ostream &os, const ValidationLevel &level) {
+  switch (level) {
+    case ValidationLevel::Off:
+      os << "off";
+      break;
+    case ValidationLevel::Cheap:
+      os << "cheap";
+      break;
+    case ValidationLevel::Full:
+      os << "full";
+      break;
+  }
+  return os;
+}
+
 bool PartitioningParams::isRatioObj() const {
   return objective == ObjectiveType::RatioCut || objective == ObjectiveType::RatioSoed || objective == ObjectiveType::RatioMaxDegree;
 }
@@ -0,0 +1,188 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "profiler.hh"
+
+#ifdef MINIPART_PROFILING
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+const int nCounters = 3;
+const char *counterNames[nCounters] = {"Cycles", "Cache misses", "Branch misses"};
+
+struct PhaseStats {
+  int64_t calls = 0;
+  double totalSeconds = 0.0;
+  double selfSeconds = 0.0;
+  uint64_t counters[nCounters] = {0, 0, 0};
+};
+
+struct Frame {
+  const char *phase;
+  Index level;
+  chrono::steady_clock::time_point start;
+  uint64_t counters[nCounters];
+  double childSeconds;
+};
+
+mutex profileMutex;
+// Phases in order of first appearance
+vector<pair<string, Index> > phaseOrder;
+map<pair<string, Index>, PhaseStats> phaseStats;
+atomic<bool> perfEnabled(false);
+atomic<bool> perfAvailable(false);
+
+thread_local vector<Frame> frames;
+
+/**
+ * Group of counters for the current thread, opened on first use
+ */
+class PerfCounters {
+ public:
+  ~PerfCounters() {
+    for (int fd : fds_) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  bool read(uint64_t *values) {
+    if (!opened_) open();
+    if (fds_[0] < 0) return false;
+    struct {
+      uint64_t nr;
+      uint64_t values[nCounters];
+    } data;
+    if (::read(fds_[0], &data, sizeof(data)) != (ssize_t) sizeof(data)) return false;
+    for (int i = 0; i < nCounters; ++i) values[i] = data.values[i];
+    return true;
+  }
+
+ private:
+  void open() {
+    opened_ = true;
+    const uint64_t configs[nCounters] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < nCounters; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds_[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+      if (fds_[i] < 0) {
+        if (perfAvailable.exchange(false)) {
+          cerr << "Performance counters are not available: " << strerror(errno) << endl;
+        }
+        for (int j = 0; j < i; ++j) {
+          close(fds_[j]);
+          fds_[j] = -1;
+        }
+        return;
+      }
+    }
+  }
+
+ private:
+  bool opened_ = false;
+  int fds_[nCounters] = {-1, -1, -1};
+};
+
+thread_local PerfCounters threadCounters;
+
+bool readCounters(uint64_t *values) {
+  if (!perfEnabled || !perfAvailable) return false;
+  return threadCounters.read(values);
+}
+} // End anonymous namespace
+
+ProfileScope::ProfileScope(const char *phase) {
+  start(phase, frames.empty() ? 0 : frames.back().level);
+}
+
+ProfileScope::ProfileScope(const char *phase, Index level) {
+  start(phase, level);
+}
+
+void ProfileScope::start(const char *phase, Index level) {
+  Frame frame;
+  frame.phase = phase;
+  frame.level = level;
+  frame.childSeconds = 0.0;
+  if (!readCounters(frame.counters)) {
+    for (int i = 0; i < nCounters; ++i) frame.counters[i] = 0;
+  }
+  frame.start = chrono::steady_clock::now();
+  frames.push_back(frame);
+}
+
+ProfileScope::~ProfileScope() {
+  Frame frame = frames.back();
+  frames.pop_back();
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - frame.start).count();
+  uint64_t counters[nCounters] = {0, 0, 0};
+  if (readCounters(counters)) {
+    for (int i = 0; i < nCounters; ++i) counters[i] -= frame.counters[i];
+  }
+  if (!frames.empty()) frames.back().childSeconds += elapsed;
+
+  lock_guard<mutex> lock(profileMutex);
+  pair<string, Index> key(frame.phase, frame.level);
+  auto it = phaseStats.find(key);
+  if (it == phaseStats.end()) {
+    phaseOrder.push_back(key);
+    it = phaseStats.emplace(key, PhaseStats()).first;
+  }
+  PhaseStats &stats = it->second;
+  ++stats.calls;
+  stats.totalSeconds += elapsed;
+  stats.selfSeconds += elapsed - frame.childSeconds;
+  for (int i = 0; i < nCounters; ++i) stats.counters[i] += counters[i];
+}
+
+void enablePerfCounters() {
+  perfEnabled = true;
+  perfAvailable = true;
+}
+
+void printProfile(ostream &os) {
+  lock_guard<mutex> lock(profileMutex);
+  bool counters = perfEnabled && perfAvailable;
+  os << "Profile:" << endl;
+  os << left << setw(28) << "\tPhase" << right << setw(6) << "Level" << setw(10) << "Calls";
+  os << setw(12) << "Total (s)" << setw(12) << "Self (s)";
+  if (counters) {
+    for (int i = 0; i < nCounters; ++i) os << setw(16) << counterNames[i];
+  }
+  os << endl;
+  for (const pair<string, Index> &key : phaseOrder) {
+    const PhaseStats &stats = phaseStats[key];
+    os << "\t" << left << setw(27) << key.first << right << setw(6) << key.second << setw(10) << stats.calls;
+    os << fixed << setprecision(3) << setw(12) << stats.totalSeconds << setw(12) << stats.selfSeconds;
+    if (counters) {
+      for (int i = 0; i < nCounters; ++i) os << setw(16) << stats.counters[i];
+    }
+    os << endl;
+  }
+  os << defaultfloat << endl;
+}
+
+} // End namespace minipart
+
+#endif
+
@@ -0,0 +1,50 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "stop_condition.hh"
+
+#include <atomic>
+#include <csignal>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+// Number of stop requests so far; each optimization only reacts to the requests made after it started
+atomic<uint64_t> stopRequests(0);
+
+void handleStopSignal(int sig) {
+  stopRequests.fetch_add(1);
+  signal(sig, SIG_DFL);
+}
+} // End anonymous namespace
+
+StopCondition::StopCondition(double timeLimit) {
+  startRequests_ = stopRequests.load();
+  hasDeadline_ = timeLimit > 0.0;
+  deadline_ = chrono::steady_clock::now();
+  if (hasDeadline_) {
+    deadline_ += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimit));
+  }
+}
+
+bool StopCondition::stop() const {
+  if (stopRequests.load(memory_order_relaxed) != startRequests_) return true;
+  return hasDeadline_ && chrono::steady_clock::now() >= deadline_;
+}
+
+void StopCondition::requestStop() {
+  stopRequests.fetch_add(1);
+}
+
+bool StopCondition::stopRequested() const {
+  return stopRequests.load(memory_order_relaxed) != startRequests_;
+}
+
+void StopCondition::installSignalHandlers() {
+  signal(SIGINT, handleStopSignal);
+  signal(SIGTERM, handleStopSignal);
+}
+
+} // End namespace minipart
+
@@ -0,0 +1,153 @@
+// Copyright (C) 2019 Gabriel Gouvine - All Rights Reserved
+
+#include "trace.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_set>
+#include <set>
+#include <stdexcept>
+
+using namespace std;
+
+namespace minipart {
+
+namespace {
+struct TraceEvent {
+  const char *name;
+  const char *argName;
+  int64_t argValue;
+  // Microseconds
+  double start;
+  double duration;
+  Index tid;
+};
+
+class ThreadBuffer;
+
+mutex traceMutex;
+atomic<bool> traceOn(false);
+string traceFile;
+chrono::steady_clock::time_point traceStart;
+Index nextThreadId = 0;
+// Identifiers of the threads that exited, reused so that short-lived workers share a few tracks
+set<Index> freeThreadIds;
+// Events of the threads that already exited
+vector<TraceEvent> finishedEvents;
+unordered_set<ThreadBuffer*> liveBuffers;
+
+/**
+ * Events of a thread, recorded without synchronization and collected when the thread exits
+ */
+class ThreadBuffer {
+ public:
+  ThreadBuffer() {
+    lock_guard<mutex> lock(traceMutex);
+    if (freeThreadIds.empty()) {
+      tid = nextThreadId++;
+    }
+    else {
+      tid = *freeThreadIds.begin();
+      freeThreadIds.erase(freeThreadIds.begin());
+    }
+    liveBuffers.insert(this);
+  }
+
+  ~ThreadBuffer() {
+    lock_guard<mutex> lock(traceMutex);
+    finishedEvents.insert(finishedEvents.end(), events.begin(), events.end());
+    liveBuffers.erase(this);
+    freeThreadIds.insert(tid);
+  }
+
+  Index tid;
+  vector<TraceEvent> events;
+};
+
+thread_local ThreadBuffer threadBuffer;
+
+double elapsedMicroseconds() {
+  return chrono::duration<double, micro>(chrono::steady_clock::now() - traceStart).count();
+}
+
+void writeEvents(ostream &s, const vector<TraceEvent> &events, Index nThreads) {
+  s << fixed << setprecision(3);
+  s << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (Index tid = 0; tid < nThreads; ++tid) {
+    s << (first ? "" : ",\n");
+    s << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid;
+    s << ",\"args\":{\"name\":\"" << (tid == 0 ? "main" : "thread ") << (tid == 0 ? "" : to_string(tid)) << "\"}}";
+    first = false;
+  }
+  for (const TraceEvent &event : events) {
+    s << (first ? "" : ",\n");
+    s << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.tid;
+    s << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+    if (event.argName != nullptr) {
+      s << ",\"args\":{\"" << event.argName << "\":" << event.argValue << "}";
+    }
+    s << "}";
+    first = false;
+  }
+  s << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+} // End anonymous namespace
+
+void openTrace(const string &name) {
+  // The calling thread is the main one
+  (void) threadBuffer.tid;
+  lock_guard<mutex> lock(traceMutex);
+  traceFile = name;
+  traceStart = chrono::steady_clock::now();
+  traceOn = true;
+}
+
+void closeTrace() {
+  if (!traceOn) return;
+  traceOn = false;
+  lock_guard<mutex> lock(traceMutex);
+  vector<TraceEvent> events = finishedEvents;
+  for (ThreadBuffer *buffer : liveBuffers) {
+    events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+    buffer->events.clear();
+  }
+  finishedEvents.clear();
+  ofstream f(traceFile);
+  if (f.fail()) throw runtime_error("Unable to open the file \"" + traceFile + "\"");
+  writeEvents(f, events, nextThreadId);
+}
+
+void disableTrace() {
+  traceOn = false;
+}
+
+bool traceEnabled() {
+  return traceOn;
+}
+
+TraceScope::TraceScope(const char *name, const char *argName, int64_t argValue)
+: name_(name)
+, argName_(argName)
+, argValue_(argValue)
+, enabled_(traceOn) {
+  if (enabled_) start_ = elapsedMicroseconds();
+}
+
+TraceScope::~TraceScope() {
+  if (!enabled_ || !traceOn) return;
+  TraceEvent event;
+  event.name = name_;
+  event.argName = argName_;
+  event.argValue = argValue_;
+  event.start = start_;
+  event.duration = elapsedMicroseconds() - start_;
+  event.tid = threadBuffer.tid;
+  threadBuffer.events.push_back(event);
+}
+
+} // End namespace minipart
+